@@ -0,0 +1 @@
+../Tx/AdcSampler.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../Tx/AdcSampler.h
\ No newline at end of file
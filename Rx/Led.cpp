@@ -0,0 +1 @@
+../Tx/Led.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../Tx/Led.h
\ No newline at end of file
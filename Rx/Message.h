@@ -0,0 +1 @@
+../Tx/Message.h
\ No newline at end of file
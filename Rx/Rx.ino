@@ -17,18 +17,29 @@
 #include <rgCsv.h>
 #include "Common.h"
 #include "Gpio.h"
+#include "Led.h"
+#include "ServoOutput.h"
 #include "Settings.h"
+#include "SpscQueue.h"
 #include "Transceiver.h"
 #include "User.h"
 
 // 0=debug off, 1=output to serial, 2=output to serial and optionally bluetooth with dbtprintln()
-#define DEBUG_ON 1
+// 3=deferred output to serial, printing does not delay the datagrams (see rgDebug.h)
+#define DEBUG_ON 3
 // 0=trace off, 1=output to serial, 2=output to serial and optionally bluetooth with trbtprintln()
 #define TRACE_ON 0
+// 0=profiling off, 1=profiling sections enabled (see rgDebug.h)
+#define PROFILE_ON 0
 #include <rgDebug.h>
 
 Settings Settings_obj;
 Transceiver Transceiver_obj;
+#if SPI_CE2_GPIO && SPI_CS2_GPIO
+// antenna diversity : this second radio follows the hop sequence of Transceiver_obj
+// place its antenna in a different orientation than the antenna of the first radio
+Transceiver Transceiver2_obj(SPI_CE2_GPIO, SPI_CS2_GPIO);
+#endif
 
 #define APP_NAME "BasicRx"
 #define APP_VERSION "1.9.1"
@@ -45,11 +56,16 @@ Transceiver Transceiver_obj;
 //  if we were listening on DEF_MONOCHAN we save the transmitter's configuration settings in our settings file, and reboot
 // MULTIFREQ : we process the user datagram and send back the ACK datagrams
 enum RxStates {SYNCHRONIZING, MONOFREQ, MULTIFREQ};
-RxStates Rx_state=SYNCHRONIZING;
+volatile RxStates Rx_state=SYNCHRONIZING;
 
 bool RunLedEnabled=(RUNLED_GPIO!=0); // true by default, false when the Pairing button is pressed
+Led RunLed_obj;
+Led ErrLed_obj;
+rgBtnManager Buttons_obj;
+
+// servo outputs configured in UserSetup() and updated by UserLoopMsg()
+ServoOutput ServoOutput_obj;
 
-uint16_t Ack_message[Transceiver::ACKVALUES];
 uint16_t Ack_type=Transceiver::DGT_SERVICE;
 
 uint16_t ErrorCounter=0;  // number of missing datagrams per second, updated once/second, available to and used by User.cpp
@@ -58,16 +74,55 @@ uint16_t ErrorCounter=0;  // number of missing datagrams per second, updated onc
 // then we will transition to MULTIFREQ after sending the last of them.
 const uint8_t SYNACKNUMBER=64;
 
+#if COM_DUAL_CORE
+// Dual-core pipeline : radio_task() runs receive() on core 0 and loop() runs the user code on core 1
+// the radio task reports each received user datagram and each timeout with a MsgEvent,
+// the user task answers each user datagram with the ACK data to send back with the next datagrams
+struct MsgEvent {
+    uint8_t result; // value returned by receive()
+    Transceiver::MsgDatagram datagram;
+};
+SpscQueue<MsgEvent, 8> MsgQueue_obj;                 // radio task -> user task
+SpscQueue<Transceiver::AckDatagram, 4> AckQueue_obj; // user task -> radio task
+TaskHandle_t UserTask_obj=NULL;
+// vTaskDelay() sleeps by whole ticks of 1 ms : the radio task sleeps until RADIO_SPIN_US before the next datagram is due,
+// then polls the radio every RADIO_POLL_US, see radio_wait()
+const micros_t RADIO_SPIN_US=1500;
+const micros_t RADIO_POLL_US=20;
+const micros_t RADIO_SPIN_MAX_US=10000; // then yield 1 tick, so that the idle task of core 0 runs and feeds the watchdog
+#endif
+
+// next datagram will arrive between Next_Eta_us and Next_Eta_us+Avg_Datagram_Period
+// Next_Eta_us is the moment where we switch to next radio channel
+micros_t Next_Eta_us=0;
+
+#if COM_LOW_POWER
+#if COM_DUAL_CORE
+#error "COM_LOW_POWER requires COM_DUAL_CORE=0"
+#endif
+// While MULTIFREQ, the radio listens only from Guard_us before Next_Eta_us until the datagram is received or times out
+// the radio stays in standby mode and the CPU in light sleep the rest of the time
+const micros_t GUARD_MIN_US=500;          // listening window width after receiving consecutive datagrams
+micros_t Guard_us=GUARD_MIN_US;           // widened after each missing datagram, up to half the datagram period
+const micros_t LIGHTSLEEP_MIN_US=2000;    // do not sleep if the listening window opens sooner than this
+const micros_t LIGHTSLEEP_WAKEUP_US=1000; // wake up this early, then wait for the exact opening of the window
+#endif
+
 void setup() {
     Serial.begin(115200);
     while (!Serial) ; // wait for serial port to connect
+    setupLog(); // start the task printing the deferred debug output
 #if DEBUG_ON
 	dbprint('\n'); for (uint8_t idx = 0; idx<6; idx++) { dbprint((char)('A'+idx)); delay(500); }
 #endif
     dbprintf("\n\n*** %s %s() : %s %s\n", __FILE_NAME__, __FUNCTION__, APP_NAME, APP_VERSION);
     dbprintf("using library %s %s\n", BTNLIB_NAME, BTNLIB_VERSION);
     dbprintf("using library %s %s\n", CSVLIB_NAME, CSVLIB_VERSION);
-    pinMode(PAIRING_GPIO, INPUT_PULLUP);
+    // the Pairing button is handled by interrupts, it is used at boot only
+    const int BUTTON_HOLD=3000; // ms, hold the button long enough to create a new file with default values
+    int pairing_btn=Buttons_obj.Add(PAIRING_GPIO, BUTTON_HOLD);
+    if (!Buttons_obj.Begin())
+		EndProgram(true, "Setup: button initialization error");
     if (RUNLED_GPIO)
         pinMode(RUNLED_GPIO, OUTPUT);
     if (ERRLED_GPIO)
@@ -79,8 +134,7 @@ void setup() {
 		EndProgram(true, "Setup: file system formatting error");
 
     // Hold the Pairing button during boot to delete the current settings file.
-    const int BUTTON_HOLD=3000; // ms, hold the button long enough to create a new file with default values
-    BtnStates btn_state=ReadBtnBlock(PAIRING_GPIO, RUNLED_GPIO, BUTTON_HOLD); // ms
+    BtnStates btn_state=Buttons_obj.WaitRelease(pairing_btn, RUNLED_GPIO);
     if (btn_state==BTN_REACHED_DURATION) {
         if (LittleFS.exists(Settings_obj.PARFILE)) {
             if (LittleFS.remove(Settings_obj.PARFILE))
@@ -91,6 +145,10 @@ void setup() {
         else
             dbprintf("Setup: settings file \"%s\" not found\n", Settings_obj.PARFILE);
     }
+
+    // from now on the leds are driven by their timers, see refresh_leds()
+    if (!RunLed_obj.Begin(RUNLED_GPIO) || !ErrLed_obj.Begin(ERRLED_GPIO))
+        EndProgram(true, "Setup: led initialization error");
  
     // Open the settings file, create it with given parameters if it does not exist
     // these parameters will make us enter the pairing mode automatically
@@ -118,40 +176,207 @@ void setup() {
 
     // Configure the transceiver
     Transceiver_obj.Setup(false, tx_device_id, rx_device_id, mono_channel, pa_level);
+#if SPI_CE2_GPIO && SPI_CS2_GPIO
+    if (Transceiver2_obj.Setup(false, tx_device_id, rx_device_id, mono_channel, pa_level))
+        Transceiver_obj.AttachDiversity(&Transceiver2_obj);
+    else
+        dbprintln("Setup: diversity radio not responding"); // continue with a single radio
+#endif
 
     // Run user setup code
     UserSetup();
 
+#if COM_DUAL_CORE
+    // from now on loop() runs only the user code, and the radio timing runs in radio_task() on core 0
+    UserTask_obj=xTaskGetCurrentTaskHandle();
+    xTaskCreatePinnedToCore(radio_task, "Radio", 4096, NULL, configMAX_PRIORITIES-1, NULL, 0);
+#endif
+
     trprintf("*** %s %s() returns after %lu ms\n", __FILE_NAME__, __FUNCTION__, millis());
 }
 
 void loop() {
+    check_serial_command();
+    profileReport(10000); // print the profiling summary every 10 seconds if PROFILE_ON
+#if COM_DUAL_CORE
+    user_loop();
+#else
     // micros_t start_timer = micros();
     // receive a datagram
     uint8_t result=receive();
 
     if (result==0) { // 0=received a DGT_USER datagram
-        UserLoopMsg(Transceiver_obj.Msg_Datagram.message);
-        Ack_type=Transceiver::DGT_USER;
-        memset(Ack_message, 0, sizeof(Ack_message));
-        UserLoopAck(Ack_message);
+        profileCall("UserLoopMsg", UserLoopMsg(Transceiver_obj.Msg_Datagram->message));
+        // fill up the next ACK datagram in place with user's data
+        if (Ack_type!=Transceiver::DGT_USER) {
+            // first user ACK datagram : this buffer still holds the service data of MONOFREQ,
+            // clear it because the user code may not overwrite all the values
+            memset(Transceiver_obj.NextAck()->message, 0, sizeof(Transceiver_obj.NextAck()->message));
+            Ack_type=Transceiver::DGT_USER;
+        }
+        UserLoopAck(Transceiver_obj.NextAck()->message);
         //dbprintf("Receive time=%lu\n", micros() - start_timer);
     }
-    
+    // waiting for the next datagram : save the settings only in the first half of the gap, as the radio task does
+    if (result==4 && Rx_state!=SYNCHRONIZING && (long)(Next_Eta_us-micros())>(long)(Transceiver_obj.Avg_Datagram_Period/2))
+        flush_settings();
+    refresh_leds(result);
+#if COM_LOW_POWER
+    if (Rx_state==MULTIFREQ && (result==0 || result==1 || result==3))
+        sleep_until_window(result==3);
+#endif
+#endif
+}
+
+#if COM_LOW_POWER
+// Put the radio in standby and the CPU in light sleep until the listening window of the next datagram opens
+// missed : true if the last datagram was not received, the window is then widened
+void sleep_until_window(bool missed) {
+    micros_t max_guard_us=Transceiver_obj.Avg_Datagram_Period/2;
+    if (missed)
+        Guard_us=min(Guard_us*2, max_guard_us);
+    else
+        Guard_us-=(Guard_us-GUARD_MIN_US)/8; // narrow the window slowly after a reception
+
+    micros_t window_us=Next_Eta_us-Guard_us;
+    if ((long)(window_us-micros())>=(long)LIGHTSLEEP_MIN_US) {
+        Transceiver_obj.Standby();
+        Serial.flush(); // the UART stops in light sleep
+        long sleep_us=(long)(window_us-micros())-LIGHTSLEEP_WAKEUP_US;
+        if (sleep_us>0) {
+            esp_sleep_enable_timer_wakeup(sleep_us);
+            esp_light_sleep_start();
+        }
+        while ((long)(window_us-micros())>0)
+            ; // wait for the exact opening of the window
+        Transceiver_obj.Listen();
+    }
+}
+#endif
+
+// Write the settings saved by receive() with Settings_obj.RequestSave() to the file system
+// this takes several ms : call this function only when no datagram is expected at once
+void flush_settings(void) {
+    if (profileCall("Settings::Flush", Settings_obj.Flush())<0)
+        EndProgram(true, "Settings write error"); // could not save settings
+}
+
+// Serial commands, sent from the serial monitor:
+//  'T' dump the radio event trace in binary, see Transceiver::DumpTrace()
+void check_serial_command(void) {
+    // the dump is written in several passes of loop() without blocking, see Transceiver::DumpTrace()
+    static bool Dump_requested=false;
+    static bool Dumping=false;
+    if (!Dump_requested && Serial.available() && Serial.read()=='T')
+        Dump_requested=true;
+    // do not mix the debug output with the binary dump : wait until the drain task has written its records,
+    // then keep it from writing the records queued meanwhile by the other tasks
+    if (Dump_requested && !Dumping)
+        Dumping=dbpause();
+    if (Dumping && Transceiver_obj.DumpTrace(Serial)) {
+        Dump_requested=Dumping=false;
+        dbresume();
+    }
+}
+
+// the leds are driven by their timers : these calls only change the pattern of a led when the state changes
+void refresh_leds(uint8_t result) {
     if (Rx_state==MULTIFREQ) {
         if (RunLedEnabled)
-            BlinkLed(RUNLED_GPIO, 2000, 20, false); // short flash once / every 2 seconds (0.5 Hz)
+            RunLed_obj.Blink(2000, 20); // short flash once / every 2 seconds (0.5 Hz)
         if (result==3)
-            FlashLed(ERRLED_GPIO, 20); // missed a datagram (timeout) : turn on ERRLED_GPIO
-        else
-            FlashLed(ERRLED_GPIO); // refresh ERRLED_GPIO
+            ErrLed_obj.Flash(20); // missed a datagram (timeout) : turn on ERRLED_GPIO
     }
     else {
         if (RunLedEnabled)
-            BlinkLed(RUNLED_GPIO, 500, 200, false); // longer flash twice / second (2 Hz)
+            RunLed_obj.Blink(500, 200); // longer flash twice / second (2 Hz)
     }
 }
 
+#if COM_DUAL_CORE
+// Radio task pinned to core 0 : receive the datagrams and hop to the next radio channel
+// nothing else runs here, so the user code cannot delay the channel hopping
+void radio_task(void *parameters) {
+    Transceiver::AckDatagram ack_dg; // newest ACK data built by the user task
+    memset(&ack_dg, 0, sizeof(ack_dg));
+    while (1) {
+        uint8_t result=receive();
+        if (result==0 || result==3) {
+            MsgEvent event;
+            event.result=result;
+            if (result==0)
+                event.datagram=*Transceiver_obj.Msg_Datagram;
+            MsgQueue_obj.Push(event); // this event is lost if the user task is more than 7 datagrams late
+            xTaskNotifyGive(UserTask_obj);
+        }
+        bool fresh_ack=false;
+        while (AckQueue_obj.Pop(&ack_dg))
+            fresh_ack=true;
+        if (Rx_state==MULTIFREQ && (result==0 || fresh_ack)) {
+            // send the newest ACK data until the user task builds fresher data
+            Ack_type=Transceiver::DGT_USER;
+            memcpy(Transceiver_obj.NextAck()->message, ack_dg.message, sizeof(ack_dg.message));
+        }
+        if (result==2 || result==4) {
+            // writing to the flash memory disables the cache of both cores and stalls this task too :
+            // save the settings only in the first half of the gap between 2 datagrams, where it delays the hopping the least
+            if (Rx_state!=SYNCHRONIZING && (long)(Next_Eta_us-micros())>(long)(Transceiver_obj.Avg_Datagram_Period/2))
+                flush_settings();
+            radio_wait();
+        }
+    }
+}
+
+// Wait before polling the radio again, called by the radio task when no datagram was available
+// the polling delay is bounded by RADIO_POLL_US when the next datagram is due : with vTaskDelay(1) alone,
+// a datagram could wait up to 1 ms in the radio, and the channel hopping would jitter by as much
+void radio_wait(void) {
+    static micros_t Last_yield_us=0; // last time the lower priority tasks of core 0 could run
+    micros_t time_now_us=micros();
+    if (Rx_state==SYNCHRONIZING) {
+        // the period is not known yet, and no channel hopping
+        vTaskDelay(1);
+        Last_yield_us=micros();
+        return;
+    }
+    const long tick_us=portTICK_PERIOD_MS*1000;
+    long sleep_us=(long)(Next_Eta_us-time_now_us)-(long)RADIO_SPIN_US;
+    if (sleep_us>=tick_us) {
+        vTaskDelay(sleep_us/tick_us); // wakes up at least RADIO_SPIN_US before the datagram is due
+        Last_yield_us=micros();
+    }
+    else if (time_now_us-Last_yield_us>=RADIO_SPIN_MAX_US) {
+        // spinning for too long, eg the datagrams are missing : receive() times out half a period after Next_Eta_us
+        vTaskDelay(1);
+        Last_yield_us=micros();
+    }
+    else
+        delayMicroseconds(RADIO_POLL_US); // busy-wait, the radio task has core 0 to itself
+}
+
+// User task running on core 1 in loop() : process the MSG datagrams and build the ACK data
+void user_loop(void) {
+    static uint8_t Last_result=4;
+    MsgEvent event;
+
+    // wait for the radio task to report a datagram, but refresh the Leds at least every 10 ms
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+    while (MsgQueue_obj.Pop(&event)) {
+        if (event.result==0) {
+            profileCall("UserLoopMsg", UserLoopMsg(event.datagram.message));
+            Transceiver::AckDatagram ack_dg;
+            memset(ack_dg.message, 0, sizeof(ack_dg.message));
+            UserLoopAck(ack_dg.message);
+            AckQueue_obj.Push(ack_dg);
+        }
+        Last_result=event.result;
+    }
+    refresh_leds(Last_result);
+    if (Last_result==3)
+        Last_result=4; // flash ERRLED_GPIO only once per timeout
+}
+#endif
+
 // Return values: 
 //  0=received a user datagram
 //  1=received a service datagram
@@ -162,11 +387,8 @@ uint8_t receive(void) {
     #define pairing_in_progress (Transceiver_obj.GetChannel()==Transceiver::DEF_MONOCHAN)
 
     uint8_t retval=2;
-    // next datagram will arrive between Next_Eta_us and Next_Eta_us+Avg_Datagram_Period
-    // Next_Eta_us is the moment where we switch to next radio channel
     bool received=false;
     bool timeout=false;
-    static micros_t Next_Eta_us=0;
     static uint16_t Prev_number=0;
     static uint16_t Multifreq_number=0; // we'll start frequency hopping *after* receiving this datagram
     static uint16_t Err_count=0;  // number of missing datagrams per second, updated once/second
@@ -183,25 +405,27 @@ uint8_t receive(void) {
     }
     if (time_now_ms >= Sig_timer+1000) {
         dbprintf("(ch 0x%02x) tx_device_id=0x%06x rx_device_id=0x%06x dg_number=%u no signal\n", 
-            Transceiver_obj.GetChannel(), Settings_obj.GetTxDeviceId(), Settings_obj.GetRxDeviceId(), Transceiver_obj.Msg_Datagram.number);
+            Transceiver_obj.GetChannel(), Settings_obj.GetTxDeviceId(), Settings_obj.GetRxDeviceId(), Transceiver_obj.Msg_Datagram->number);
         Sig_timer=time_now_ms;
     }
 
     // receive next datagram and send the ACK datagram waiting in the Ack buffer
     micros_t time_now_us=micros();
-    if (Transceiver_obj.Receive(Ack_type, Ack_message)) {
+    if (Transceiver_obj.Receive(Ack_type)) {
         Sig_timer=time_now_ms; // to print "no signal" warning every second 
         received=true;
-        memset(Ack_message, 0, sizeof(Ack_message)); // clear the Ack buffer for the next ACK datagram
+        // clear the Ack buffer for the next service ACK datagram, user's data is written in place by UserLoopAck()
+        if (Rx_state!=MULTIFREQ)
+            memset(Transceiver_obj.NextAck()->message, 0, sizeof(Transceiver_obj.NextAck()->message));
 
 #ifdef DEBUG_PRINT_MSG_DATAGRAMS
         dbprint("Msg: ");
-        Transceiver_obj.PrintMsgDatagram(Transceiver_obj.Msg_Datagram);
+        Transceiver_obj.PrintMsgDatagram(*Transceiver_obj.Msg_Datagram);
         dbprint('\n');
 #endif
 #ifdef DEBUG_PRINT_ACK_DATAGRAMS
         dbprint("Ack: ");
-        Transceiver_obj.PrintAckDatagram(Transceiver_obj.Ack_Datagram);
+        Transceiver_obj.PrintAckDatagram(*Transceiver_obj.Ack_Datagram);
         dbprint('\n');
 #endif
     }
@@ -212,8 +436,9 @@ uint8_t receive(void) {
             Ack_type=Transceiver::DGT_SERVICE; // ack datagrams sent while SYNCHRONIZING are empty
             if (Transceiver_obj.Avg_Datagram_Period) {
                 Rx_state=MONOFREQ;
+                Transceiver_obj.TraceState=Rx_state;
                 // send SYNACKNUMBER ack datagrams informing Tx that we are synchronized and will switch to MULTIFREQ at this datagram number
-                Multifreq_number=Transceiver_obj.Msg_Datagram.number+SYNACKNUMBER;
+                Multifreq_number=Transceiver_obj.Msg_Datagram->number+SYNACKNUMBER;
                 dbprintf("synchronized after %lu ms, period=%lu µs\n", millis(), Transceiver_obj.Avg_Datagram_Period);
             }
             retval=2; // synchronization in progress
@@ -221,18 +446,18 @@ uint8_t receive(void) {
 
         if (Rx_state==MONOFREQ || Rx_state==MULTIFREQ) {
             Next_Eta_us=time_now_us+Transceiver_obj.Avg_Datagram_Period;
-            Prev_number=Transceiver_obj.Msg_Datagram.number;
+            Prev_number=Transceiver_obj.Msg_Datagram->number;
             if (Rx_state==MONOFREQ) {
                 // the transmitter is still sending MSG datagrams containing its configuration settings
                 Ack_type=Transceiver::DGT_SERVICE | Transceiver::DGT_SYNCHRONIZED;
                 if (pairing_in_progress)
                     Ack_type|=Transceiver::DGT_PAIRING;
-                Ack_message[0]=Multifreq_number;
-                Ack_message[1]=Transceiver_obj.GetSessionKey(); // $$DEBUG
+                Transceiver_obj.NextAck()->message[0]=Multifreq_number;
+                Transceiver_obj.NextAck()->message[1]=Transceiver_obj.GetSessionKey(); // $$DEBUG
             }
             else {
                 // MULTIFREQ
-                if (Transceiver_obj.Msg_Datagram.type & Transceiver::DGT_USER)
+                if (Transceiver_obj.Msg_Datagram->type & Transceiver::DGT_USER)
                     retval=0; // received user datagram
                 else
                     retval=1; // received service datagram
@@ -249,6 +474,7 @@ uint8_t receive(void) {
                 Next_Eta_us+=Transceiver_obj.Avg_Datagram_Period;
                 Prev_number++;
                 Err_count++;
+                Transceiver_obj.TraceMissed(Prev_number);
                 timeout=true;
                 retval=3; // timeout : no datagram received in the expected time slice
             }
@@ -266,11 +492,12 @@ uint8_t receive(void) {
             if (Prev_number != Multifreq_number) {
                 if (!Acquired_tx_config) {
                     // Acquire the transmitter's configuration settings
-                    uint16_t tx_device_id=Transceiver_obj.Msg_Datagram.message[0];
-                    uint16_t rx_device_id=Transceiver_obj.Msg_Datagram.message[1];
-                    uint16_t mono_channel=Transceiver_obj.Msg_Datagram.message[2];
-                    uint16_t pa_level=Transceiver_obj.Msg_Datagram.message[3];
-                    uint16_t session_key=Transceiver_obj.Msg_Datagram.message[4];
+                    uint16_t *message=Transceiver_obj.Msg_Datagram->message; // shortcut
+                    uint16_t tx_device_id=message[0];
+                    uint16_t rx_device_id=message[1];
+                    uint16_t mono_channel=message[2];
+                    uint16_t pa_level=message[3];
+                    uint16_t session_key=message[4];
                     // Register the session key in RAM in order to use it later for frequency hopping
                     Transceiver_obj.SetSessionKey(session_key); // random seed used to generate the RF24Channels[] array
                     Transceiver_obj.AssignChannels(); // assign values to the array of radio channels
@@ -289,20 +516,23 @@ uint8_t receive(void) {
                         Settings_obj.SetPaLevel(pa_level);
                         save_settings=true;
                     }
-                    if (save_settings) {
-                        if (Settings_obj.Save()<0)
-                            EndProgram(true, "Settings write error"); // false=halt command, could not save settings
-                    }
+                    if (save_settings)
+                        Settings_obj.RequestSave(); // written by flush_settings(), writing to the flash memory here would delay the datagrams
                     Acquired_tx_config=true;
                 }
             }
             else {
                 if (pairing_in_progress) {
                     dbprintln("Reboot after pairing");
+                    flush_settings(); // the paired settings must be saved before rebooting
+                    dbflush();
                     EndProgram(true); // true=reset command
                 }
 
+                // clear the service data from the next ACK datagram, the user code may not overwrite all the values
+                memset(Transceiver_obj.NextAck()->message, 0, sizeof(Transceiver_obj.NextAck()->message));
                 Rx_state=MULTIFREQ;
+                Transceiver_obj.TraceState=Rx_state;
                 dbprintf("MULTIFREQ after %lu ms, period=%lu µs\n", millis(), Transceiver_obj.Avg_Datagram_Period);
             }
         }
@@ -0,0 +1 @@
+../Tx/Schema.h
\ No newline at end of file
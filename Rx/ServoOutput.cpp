@@ -0,0 +1,75 @@
+/* This program is published under the GNU General Public License. 
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL 
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/******************************************************************************
+* WARNING: This file is part of the nRF24L01-FHSS project base code
+* and user should not modify it. Any user code stored in this file could be
+* made inoperable by subsequent releases of the project.
+******************************************************************************/
+
+#include "ServoOutput.h"
+
+/* Configure the LEDC timer and one channel per servo, the outputs stay low until the first call to Write()
+	gpios		array of count gpios, count is limited to MAXSERVOS
+	frequency	servo refresh rate in Hz, 50-333
+	sync		true=restart the period at each Write(), see ServoOutput.h
+   Return value: true=success, false=LEDC configuration error
+*/
+bool ServoOutput::Begin(const uint8_t *gpios, uint8_t count, uint16_t frequency, bool sync) {
+    mCount=count<MAXSERVOS ? count : MAXSERVOS;
+    mSync=sync;
+    frequency=constrain(frequency, 50, 333);
+    mPeriodUs=1000000UL/frequency;
+    mDutyScale=((1UL<<SERVO_RESOLUTION)<<16)/mPeriodUs;
+
+    ledc_timer_config_t timer_config={};
+    timer_config.speed_mode=SERVO_MODE;
+    timer_config.duty_resolution=SERVO_RESOLUTION;
+    timer_config.timer_num=SERVO_TIMER;
+    timer_config.freq_hz=frequency;
+    timer_config.clk_cfg=LEDC_AUTO_CLK;
+    if (ledc_timer_config(&timer_config)!=ESP_OK)
+        return false;
+
+    for (uint8_t idx=0; idx<mCount; idx++) {
+        ledc_channel_config_t channel_config={};
+        channel_config.gpio_num=gpios[idx];
+        channel_config.speed_mode=SERVO_MODE;
+        channel_config.channel=(ledc_channel_t)idx;
+        channel_config.timer_sel=SERVO_TIMER;
+        channel_config.duty=0;
+        channel_config.hpoint=0; // the pulses of all the channels start with the period
+        if (ledc_channel_config(&channel_config)!=ESP_OK)
+            return false;
+    }
+    mStartUs=micros();
+    return true;
+}
+
+// Set the pulse widths of all the servos at once
+// pulses : array of pulse widths in µs, one per servo, they are limited to MIN_PULSE-MAX_PULSE
+void ServoOutput::Write(const uint16_t *pulses) {
+    for (uint8_t idx=0; idx<mCount; idx++) {
+        uint32_t pulse=constrain(pulses[idx], MIN_PULSE, MAX_PULSE);
+        ledc_set_duty(SERVO_MODE, (ledc_channel_t)idx, (pulse*mDutyScale)>>16);
+    }
+    for (uint8_t idx=0; idx<mCount; idx++)
+        ledc_update_duty(SERVO_MODE, (ledc_channel_t)idx);
+
+    if (mSync) {
+        // position in the current period, the timer restarts by itself at the end of each period
+        unsigned long time_now=micros();
+        uint32_t position=(time_now-mStartUs)%mPeriodUs;
+        if (position>=MAX_PULSE+SYNC_MARGIN) {
+            // no pulse in progress : restart the period now, the new pulses start at once
+            ledc_timer_rst(SERVO_MODE, SERVO_TIMER);
+            mStartUs=time_now;
+        }
+    }
+}
@@ -0,0 +1,51 @@
+/* This program is published under the GNU General Public License. 
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL 
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/******************************************************************************
+* WARNING: This file is part of the nRF24L01-FHSS project base code
+* and user should not modify it. Any user code stored in this file could be
+* made inoperable by subsequent releases of the project.
+******************************************************************************/
+
+#pragma once
+#include <Arduino.h>
+#include <driver/ledc.h>
+
+/* Servo output stage using the LEDC peripheral
+   all the servos share one LEDC timer, so that their pulses start at the same time
+   Write() updates the pulse widths of all the servos in one batch, they take effect at the beginning of the next period
+   frequency : servo refresh rate, 50 Hz for analog servos, up to 333 Hz for digital servos
+   sync=true : Write() restarts the period, so that the pulses start when the datagram arrives
+    the servos are then refreshed at the datagram rate (COM_TRANS_DGS) : use servos which accept this rate
+    and give a frequency below the datagram rate (eg COM_TRANS_DGS*4/5), it is used only when datagrams are missing
+   the period is not restarted while a pulse is in progress, the next Write() will do it
+   the LEDC timer SERVO_TIMER and the channels 0 to count-1 are reserved, do not use them with ledcAttach()
+*/
+class ServoOutput {
+    public:
+        static const uint8_t MAXSERVOS=8;
+        static const uint16_t MIN_PULSE=500;   // µs
+        static const uint16_t MAX_PULSE=2500;  // µs
+        static const uint16_t SYNC_MARGIN=100; // µs, after the longest pulse
+
+    private:
+        static const ledc_mode_t SERVO_MODE=LEDC_LOW_SPEED_MODE;
+        static const ledc_timer_t SERVO_TIMER=LEDC_TIMER_3;
+        static const ledc_timer_bit_t SERVO_RESOLUTION=LEDC_TIMER_14_BIT;
+
+        uint8_t mCount=0;
+        bool mSync=false;
+        uint32_t mPeriodUs=0;
+        uint32_t mDutyScale=0;    // duty=(pulse*mDutyScale)>>16
+        unsigned long mStartUs=0; // micros() when the period was restarted
+
+    public:
+        bool Begin(const uint8_t *gpios, uint8_t count, uint16_t frequency=50, bool sync=false);
+        void Write(const uint16_t *pulses);
+};
@@ -0,0 +1 @@
+../Tx/SpscQueue.h
\ No newline at end of file
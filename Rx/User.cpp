@@ -9,7 +9,9 @@
 
 #include <Arduino.h> // for Serial
 #include "User.h"
-#include "PowerSensor.h"
+#include "Message.h"
+#include "AdcSampler.h"
+#include "ServoOutput.h"
 #include "Common.h"
 #include "Gpio.h"
 
@@ -20,65 +22,80 @@
 #include <rgDebug.h>
 
 extern uint16_t ErrorCounter;  // number of missing datagrams per second, updated once/second
+extern ServoOutput ServoOutput_obj;
 
-// ADC input at POWERSENSOR_GPIO, compute 2 average values/s, use 10 bit sample resolution
-PowerSensor PowerSensor_obj(POWERSENSOR_GPIO, 2, 10);
+// ADC inputs sensing the power supply, add here the battery current sensor and the BEC rails if any
+// the ADC runs continuously, use 10 bit sample resolution and 400 conversions per channel : about 50 frames/s
+const uint8_t POWERSENSOR_GPIOS[]={POWERSENSOR_GPIO};
+AdcSampler PowerSensor_obj;
 // 4614 mV sampled as 1728 mV on my system, adjust it for your own hardware
 const float POWERSENSOR_CALIBRATION = 4614.0 / 1728.0;
 
 // User may add code after this line ------------------------------------------
 
-// To use the ESP32Servo library, open the Library Manager in the Arduino IDE and install it from there
-#include <ESP32Servo.h>
-
 // Move the servos using these PWM outputs
 const uint8_t PWM_GPIOS[]={USR_CHAN1_GPIO, USR_CHAN2_GPIO, USR_CHAN3_GPIO, USR_CHAN4_GPIO};
-Servo Servo_obj[sizeof(PWM_GPIOS)];
+// 50 Hz for analog servos, up to 333 Hz for digital servos
+// SERVO_SYNC=true starts the pulses when each datagram arrives, the servos must then accept COM_TRANS_DGS Hz, see ServoOutput.h
+const uint16_t SERVO_FREQUENCY=50;
+const bool SERVO_SYNC=false;
 
 // Turn on/off the Leds using these digital outputs
 const uint8_t BIN_GPIOS[]={USR_CHAN5_GPIO, USR_CHAN6_GPIO};
 
+// Log the reception errors and the power supply voltage 10 times per second to the file system
+// 0=disabled, 1=enabled ; copy the file with the LittleFS upload/download tool of your IDE
+#define USR_LOG_ON 0
+#if USR_LOG_ON
+#include <rgCsvLog.h>
+rgCsvLog Log_obj;
+const unsigned long LOG_PERIOD_MS=100;
+#endif
+
 // User setup example code
 void UserSetup(void) {
-     PowerSensor_obj.Config();
+    if (!PowerSensor_obj.Config(POWERSENSOR_GPIOS, sizeof(POWERSENSOR_GPIOS), 10, 400))
+        dbprintln("UserSetup: power sensor error");
 
-    // ESP32Servo setup
-	for (uint8_t idx=0; idx<sizeof(PWM_GPIOS); idx++) {
-		Servo_obj[idx].setPeriodHertz(50);
-		Servo_obj[idx].attach(PWM_GPIOS[idx], MIN_PULSE_WIDTH, MAX_PULSE_WIDTH);
-	}
+    // Servo outputs setup
+    if (!ServoOutput_obj.Begin(PWM_GPIOS, sizeof(PWM_GPIOS), SERVO_SYNC ? COM_TRANS_DGS*4/5 : SERVO_FREQUENCY, SERVO_SYNC))
+        dbprintln("UserSetup: servo output error");
 
     // Init the digital outputs (Leds)
     for (uint8_t idx=0; idx<sizeof(BIN_GPIOS); idx++)
         pinMode(BIN_GPIOS[idx], OUTPUT);
+
+#if USR_LOG_ON
+    // write every 4 KB or every 5 s, keep 2 older files of 256 KB
+    if (Log_obj.Begin("/rxlog.csv", 4096, 4096, 5000, 256*1024, 2)!=0)
+        dbprintln("UserSetup: log file error");
+    Log_obj.AppendRow("# millis,errors,millivolts");
+#endif
 }
 
 /* User loop code : incoming Msg_Datagram
    process the MSG datagram here
    it contains the data received from the transmitter
    typically this data is a list of potentiometers/switches values or sensor readings
-   Example message layout:
-   [0]  value of USR_CHAN1_GPIO (P1)
-   [1]  value of USR_CHAN2_GPIO (P2)
-   [2]  value of USR_CHAN3_GPIO (P3)
-   [3]  value of USR_CHAN4_GPIO (P4)
-   [4]  state of USR_CHAN5_GPIO (SW1)
-   [5]  state of USR_CHAN6_GPIO (SW2)
+   The layout of message is declared by MsgSchema in Message.h, which is shared with the transmitter
+   Example message layout (MsgSchema):
+   4 x ServoPulse   value of USR_CHAN1_GPIO to USR_CHAN4_GPIO (P1 to P4)
+   2 x SwitchState  state of USR_CHAN5_GPIO and USR_CHAN6_GPIO (SW1, SW2)
 */
 void UserLoopMsg(uint16_t *message) {
     //static uint16_t Debug_print_counter=0; Debug_print_counter++;
 
-    // Move the servos
-    for (uint8_t idx=0; idx<sizeof(PWM_GPIOS); idx++) {
-        uint16_t pulse=message[idx];
-        Servo_obj[idx].write(pulse);
-        //if (Debug_print_counter%20==0) dbprintf("Chan%d=%d ", idx+1, pulse);
-    }
+    uint16_t pulse[sizeof(PWM_GPIOS)];
+    uint8_t state[sizeof(BIN_GPIOS)];
+    MsgSchema::Unpack(message, pulse[0], pulse[1], pulse[2], pulse[3], state[0], state[1]);
+
+    // Move the servos, all at once
+    ServoOutput_obj.Write(pulse);
+    //if (Debug_print_counter%20==0) for (uint8_t idx=0; idx<sizeof(PWM_GPIOS); idx++) dbprintf("Chan%d=%d ", idx+1, pulse[idx]);
     // Turn on/off the Leds
     for (uint8_t idx=0; idx<sizeof(BIN_GPIOS); idx++) {
-        uint8_t value=message[idx+sizeof(PWM_GPIOS)];
-        digitalWrite(BIN_GPIOS[idx], value);
-        //if (Debug_print_counter%20==0) dbprintf("Chan%d=%d ", idx+sizeof(PWM_GPIOS)+1, value);
+        digitalWrite(BIN_GPIOS[idx], state[idx]);
+        //if (Debug_print_counter%20==0) dbprintf("Chan%d=%d ", idx+sizeof(PWM_GPIOS)+1, state[idx]);
     }
     //if (Debug_print_counter%20==0) dbprintln("");
 }
@@ -87,23 +104,35 @@ void UserLoopMsg(uint16_t *message) {
    set your outgoing message here
    it contains the data that is going to be sent back to the transmitter after receiving the next datagram
    typically this data is a list of values related to the receiver state (reception error rate, sensor readings, battery charge)
-   Update Transceiver.ACKVALUES to match your data length
-   Example message layout:
-   [0]  Receiver errors count
-   [1]  Receiver power supply voltage
+   The layout of message is declared by AckSchema in Message.h, which is shared with the transmitter
+   message points directly into the next ACK datagram, it is not cleared and still contains
+   the values of an older datagram : AckSchema::Pack() sets all the values it uses
+   Example message layout (AckSchema):
+   ErrorCount   Receiver errors count
+   Millivolts   Receiver power supply voltage
 */
 void UserLoopAck(uint16_t *message) {
     
     // Example code:
 
-    // message[0] = reception error rate (number of missing datagrams / second)
-    message[0]=ErrorCounter; 
-
-    // message[1] = power supply voltage in millivolts
-    static uint16_t Last_voltage=0; // use this buffered value if ReadVoltage() returns false
+    // power supply voltage in millivolts
+    // the moving average of channel 0 is updated in the background, ReadVoltage() returns false until the first frame
+    static uint16_t Last_voltage=0;
     uint16_t avg_millivolts;
     if (PowerSensor_obj.ReadVoltage(POWERSENSOR_CALIBRATION, &avg_millivolts))
         Last_voltage=avg_millivolts;
-    message[1]=Last_voltage;
+
+    // reception error rate (number of missing datagrams / second) and power supply voltage
+    AckSchema::Pack(message, ErrorCounter, Last_voltage);
+
+#if USR_LOG_ON
+    // AppendRow() returns at once, the file is written by a background task
+    static unsigned long Log_timer=0;
+    unsigned long time_now_ms=millis();
+    if (time_now_ms-Log_timer>=LOG_PERIOD_MS) {
+        Log_timer=time_now_ms;
+        Log_obj.AppendRow("%lu,%u,%u", time_now_ms, ErrorCounter, Last_voltage);
+    }
+#endif
 }
 
@@ -17,7 +17,7 @@ void UserLoopAck(uint16_t *message);
 // User may add code after this line ------------------------------------------
 
 // Example code: we use 4 servos and 2 Leds, controled by 4 potentiometers and 2 switches on the transmitter
-// we have set COM_MSGVALUES and COM_ACKVALUES accordingly in the "Global settings" section of Common.h
+// the message layouts are declared in Message.h, COM_MSGVALUES and COM_ACKVALUES are set accordingly in Common.h
 
 #define USR_CHAN1_GPIO 32 // connected to Servo #1
 #define USR_CHAN2_GPIO 33 // connected to Servo #2
@@ -0,0 +1,163 @@
+/* This program is published under the GNU General Public License. 
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL 
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/******************************************************************************
+* WARNING: This file is part of the nRF24L01-FHSS project base code
+* and user should not modify it. Any user code stored in this file could be
+* made inoperable by subsequent releases of the project.
+******************************************************************************/
+
+#include "AdcSampler.h"
+
+AdcSampler *AdcSampler::Instance=NULL;
+
+/* Configure the ADC and start the continuous conversions, a frame is completed every conversions*channel_count/adc_frequency seconds
+	adc_gpios		array of channel_count gpios, channel_count is limited to MAXCHANNELS
+					Continuous sampling - ONLY ADC1 pins are supported (GPIO32 - GPIO39)
+	resolution		9-12 bits
+	conversions		number of conversions per channel in a frame, the driver returns their average
+	adc_frequency	sampling frequency of ADC in Hz, minimum 20 kHz
+	millivolts		true=filter the values in millivolts, eg to sense a voltage ; false=filter the raw values, eg to read a potentiometer
+   Return value: true=success, false=the ADC is already used by another object or configuration error
+*/
+bool AdcSampler::Config(const uint8_t *adc_gpios, uint8_t channel_count, uint8_t resolution, uint32_t conversions, uint32_t adc_frequency, bool millivolts) {
+    if (Instance)
+        return false;
+    Instance=this;
+    mChannelCount=channel_count<MAXCHANNELS ? channel_count : MAXCHANNELS;
+    memcpy(mAdcGpio, adc_gpios, mChannelCount);
+    mMillivolts=millivolts;
+
+    // low priority : the filters are updated when the radio and the user code are idle
+    if (xTaskCreate(filter_task, "AdcSampler", 2048, this, tskIDLE_PRIORITY+1, &mTask)!=pdPASS) {
+        Instance=NULL;
+        return false;
+    }
+
+    // Optional for ESP32: Set the resolution to 9-12 bits (default is 12 bits)
+    analogContinuousSetWidth(resolution);
+
+    // Optional: Set different attenuation (default is ADC_11db)
+    analogContinuousSetAtten(ADC_11db);
+
+    // Setup ADC Continuous with following input:
+    // array of pins, count of the pins, how many conversions per pin in one cycle will happen, sampling frequency, callback function
+    if (!analogContinuous(mAdcGpio, mChannelCount, conversions, adc_frequency, &on_frame_complete) || !analogContinuousStart()) {
+        vTaskDelete(mTask);
+        mTask=NULL;
+        Instance=NULL;
+        return false;
+    }
+    return true;
+}
+
+// Copy the newest values of given channel, lock-free
+// return value: true=success, false=no frame completed yet or invalid channel
+bool AdcSampler::Get(uint8_t channel, Values *values_out) {
+    if (channel>=mChannelCount)
+        return false;
+    Channel *channel_obj=&mChannels[channel];
+    uint32_t sequence;
+    do {
+        sequence=channel_obj->sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+            continue; // filter_task() is writing the values
+        *values_out=channel_obj->values;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) || channel_obj->sequence.load(std::memory_order_relaxed)!=sequence);
+    return values_out->frames>0;
+}
+
+// return the moving average in mV of given channel, using given calibration coef, if the values are in millivolts
+// (give calibration=1 to get the raw voltage)
+bool AdcSampler::ReadVoltage(const float calibration, uint16_t *avg_millivolts_out, uint8_t channel) {
+    Values values;
+    bool retval=Get(channel, &values);
+    if (retval)
+        *avg_millivolts_out=values.average*calibration;
+    return retval;
+}
+
+// ISR Function that will be triggered when ADC conversion is done
+void ARDUINO_ISR_ATTR AdcSampler::on_frame_complete(void) {
+    BaseType_t higher_priority_task_woken=pdFALSE;
+    vTaskNotifyGiveFromISR(Instance->mTask, &higher_priority_task_woken);
+    if (higher_priority_task_woken)
+        portYIELD_FROM_ISR();
+}
+
+// Read each frame completed by the DMA and update the filters
+void AdcSampler::filter_task(void *parameters) {
+    AdcSampler *sensor_obj=(AdcSampler *)parameters;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (analogContinuousRead(&sensor_obj->mResult, 0)) {
+            for (uint8_t idx=0; idx<sensor_obj->mChannelCount; idx++)
+                sensor_obj->update_channel(&sensor_obj->mChannels[idx], sensor_obj->mResult[idx].avg_read_raw,
+                    sensor_obj->mMillivolts ? sensor_obj->mResult[idx].avg_read_mvolts : sensor_obj->mResult[idx].avg_read_raw);
+        }
+    }
+}
+
+// constant time : the running sum of the moving average is updated with the newest and the oldest samples,
+// and the median is computed on MEDIAN_SIZE samples
+void AdcSampler::update_channel(Channel *channel, uint16_t raw, uint16_t value) {
+    Values values=channel->values;
+    if (values.frames==0) {
+        // fill the filters with the first sample, so that their output is valid at once
+        for (uint8_t idx=0; idx<AVERAGE_SIZE; idx++)
+            channel->average_ring[idx]=value;
+        channel->average_sum=(uint32_t)value*AVERAGE_SIZE;
+        for (uint8_t idx=0; idx<MEDIAN_SIZE; idx++)
+            channel->median_ring[idx]=value;
+        channel->average_idx=0;
+        channel->median_idx=0;
+        channel->ema_fp=(int32_t)value<<8;
+    }
+
+    // moving average
+    channel->average_sum+=value-channel->average_ring[channel->average_idx];
+    channel->average_ring[channel->average_idx]=value;
+    channel->average_idx=(channel->average_idx+1)%AVERAGE_SIZE;
+
+    // exponential moving average
+    channel->ema_fp+=(((int32_t)value<<8)-channel->ema_fp)>>EMA_SHIFT;
+
+    // median : insertion sort of a copy of the ring
+    channel->median_ring[channel->median_idx]=value;
+    channel->median_idx=(channel->median_idx+1)%MEDIAN_SIZE;
+    uint16_t sorted[MEDIAN_SIZE];
+    for (uint8_t idx=0; idx<MEDIAN_SIZE; idx++) {
+        uint16_t sample=channel->median_ring[idx];
+        int8_t pos=idx-1;
+        for (; pos>=0 && sorted[pos]>sample; pos--)
+            sorted[pos+1]=sorted[pos];
+        sorted[pos+1]=sample;
+    }
+
+    values.raw=raw;
+    values.value=value;
+    values.average=channel->average_sum/AVERAGE_SIZE;
+    values.ema=(channel->ema_fp+128)>>8;
+    values.median=sorted[MEDIAN_SIZE/2];
+    values.frames++;
+
+    // publish
+    uint32_t sequence=channel->sequence.load(std::memory_order_relaxed);
+    channel->sequence.store(sequence+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    channel->values=values;
+    channel->sequence.store(sequence+2, std::memory_order_release);
+}
+
+// Copy the newest values of all the channels, the copies are returned by GetLatched()
+void AdcSampler::Latch(void) {
+    for (uint8_t idx=0; idx<mChannelCount; idx++)
+        Get(idx, &mLatched[idx]);
+}
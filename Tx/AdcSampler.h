@@ -0,0 +1,91 @@
+/* This program is published under the GNU General Public License. 
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL 
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/******************************************************************************
+* WARNING: This file is part of the nRF24L01-FHSS project base code
+* and user should not modify it. Any user code stored in this file could be
+* made inoperable by subsequent releases of the project.
+******************************************************************************/
+
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+/* Multi-channel ADC acquisition, eg the potentiometers of Tx, or the battery voltage, current and BEC rails of Rx
+   the ADC runs continuously in DMA mode : it is started once by Config() and never stopped
+   each time the DMA completes a frame (conversions per channel, averaged by the driver : oversampling)
+   a low priority task updates 3 filters per channel in constant time :
+    - moving average of the last AVERAGE_SIZE frames
+    - exponential moving average, alpha=1/2^EMA_SHIFT
+    - median of the last MEDIAN_SIZE frames, rejects the isolated spikes
+   Get() returns the newest values without locking, it may be called from any task
+   Latch() copies the newest values of all channels at once, then GetLatched() returns this copy :
+   Tx calls Latch() at a fixed phase before building each MSG datagram, so UserLoopMsg() reads no ADC input in the slot
+   the ADC continuous driver exists only once : only one AdcSampler object can be configured
+*/
+class AdcSampler {
+    public:
+        static const uint8_t MAXCHANNELS=6;
+        static const uint8_t AVERAGE_SIZE=8;
+        static const uint8_t MEDIAN_SIZE=5;
+        static const uint8_t EMA_SHIFT=3;
+
+        // the values are in millivolts, or raw ADC values, see Config()
+        struct Values {
+            uint16_t raw;        // newest frame, raw ADC value, max value depends on the resolution
+            uint16_t value;      // newest frame
+            uint16_t average;
+            uint16_t ema;
+            uint16_t median;
+            uint32_t frames;     // number of frames since Config()
+        };
+
+    private:
+        // ADC1 gpios that will be used for ADC Continuous mode
+        uint8_t mAdcGpio[MAXCHANNELS];
+        uint8_t mChannelCount=0;
+
+        // true=filter the values in millivolts computed by the driver, false=filter the raw values
+        bool mMillivolts=true;
+
+        // Result structure for ADC Continuous reading
+        adc_continuous_data_t *mResult = NULL;
+
+        // Filters of a channel, written by filter_task() only
+        struct Channel {
+            uint16_t average_ring[AVERAGE_SIZE];
+            uint32_t average_sum;
+            uint16_t median_ring[MEDIAN_SIZE];
+            uint8_t average_idx;
+            uint8_t median_idx;
+            int32_t ema_fp;  // fixed point, 8 fractional bits
+            // Values are published with a sequence lock : odd while filter_task() updates them
+            std::atomic<uint32_t> sequence{0};
+            Values values={};
+        };
+        Channel mChannels[MAXCHANNELS];
+        Values mLatched[MAXCHANNELS]={};
+
+        TaskHandle_t mTask=NULL;
+        static AdcSampler *Instance; // the object using the ADC continuous driver
+
+        static void ARDUINO_ISR_ATTR on_frame_complete(void);
+        static void filter_task(void *parameters);
+        void update_channel(Channel *channel, uint16_t raw, uint16_t value);
+        
+    public:
+        bool Config(const uint8_t *adc_gpios, uint8_t channel_count, uint8_t resolution=12, uint32_t conversions=50, uint32_t adc_frequency=20000, bool millivolts=true);
+        bool IsConfigured(void) { return mTask!=NULL; }
+        uint8_t GetChannelCount(void) { return mChannelCount; }
+        bool Get(uint8_t channel, Values *values_out);
+        bool ReadVoltage(const float calibration, uint16_t *avg_millivolts_out, uint8_t channel=0);
+        void Latch(void);
+        // values of given channel copied by the last call to Latch(), frames=0 if none
+        const Values &GetLatched(uint8_t channel) { return mLatched[channel<MAXCHANNELS ? channel : 0]; }
+};
@@ -15,6 +15,7 @@
 
 #include "Common.h"
 #include "Gpio.h"
+#include "Led.h"
 #include <bootloader_random.h> // for GetRandomInt32()
 
 // 0=debug off, 1=output to serial, 2=output to serial and optionally bluetooth with dbtprintln()
@@ -23,6 +24,8 @@
 #define TRACE_ON 0
 #include <rgDebug.h>
 
+extern Led ErrLed_obj; // defined in Tx.ino and Rx.ino
+
 // Blink the led, non blocking call : call it repeatedly
 // this function can deal only with a single led
 // period : time the led is on + time the led is off, in ms
@@ -85,6 +88,8 @@ void EndProgram(bool reset) {
 	}
 	else {
 		const int HALTED_DELAY=60000; // ms
+		// stop the pattern driven by the timer of ErrLed_obj, it would toggle ERRLED_GPIO too
+		ErrLed_obj.Off();
 		while (1) {
 			dbprintln("Program halted");
 			if (ERRLED_GPIO) {
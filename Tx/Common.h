@@ -19,14 +19,14 @@
 
 // A. User *should* adjust the next 2 values to match what he is doing in User.cpp:
 
-// size of the user data (uint16_t) transmitted  by Tx to Rx, min=4, max=14
+// size of the user data (uint16_t) transmitted  by Tx to Rx, min=5, max=14
 // more data takes longer to transmit, implying less time available for your processing in User.cpp
-// see structure of MsgDatagram in Transceiver.h
-#define COM_MSGVALUES   6   // 6 because our example code demonstrates a 6-channels RC transmitter
+// see structure of MsgDatagram in Transceiver.h, it must hold MsgSchema::WORDS values (see Message.h)
+#define COM_MSGVALUES   5   // our 6-channels RC example packs into 3 values, 5 are needed by the service datagrams
 
-// size of the user data (uint16_t) transmitted  by Rx to Tx, min=1, max=14 
+// size of the user data (uint16_t) transmitted  by Rx to Tx, min=2, max=14 
 // more data takes longer to transmit, implying less time available for your processing in User.cpp
-#define COM_ACKVALUES   2   // see structure of AckDatagram in Transceiver.h
+#define COM_ACKVALUES   2   // see structure of AckDatagram in Transceiver.h and AckSchema in Message.h
 
 // B. User *may* modify the following values if he knows what he is doing :
 
@@ -61,6 +61,27 @@
 // 	Alternatively, if transmission errors are acceptable then set ART_ATTEMPTS=0 to disable auto retransmission entirely
 #define COM_ART_ATTEMPTS 0
 
+// Dual-core pipeline:
+//  0=everything runs in loop() on core 1 : radio, user code, Leds and debug output
+//  1=the radio timing runs in a high priority task pinned to core 0, and loop() runs the user code on core 1
+//    both tasks exchange the datagrams through lock-free queues (see SpscQueue.h)
+//    so that a long processing in User.cpp cannot delay the radio channel hopping
+#define COM_DUAL_CORE   0
+
+// Low power:
+//  0=the CPU waits for the next datagram without sleeping
+//  1=the CPU enters light sleep between datagrams while the nRF24 stays in standby mode
+//    Tx sleeps until the next slot, Rx sleeps until a listening window opened around the expected arrival time
+//    of the next datagram, this window widens after each missing datagram
+//    this mode requires COM_DUAL_CORE=0
+#define COM_LOW_POWER   0
+
+// Radio event trace:
+//  number of datagrams recorded by the trace ring of the Transceiver, the oldest records are overwritten
+//  the ring is dumped in binary by sending 'T' on the serial port, use tools/trace2csv.cpp to decode the dump
+//  each record takes 12 bytes of RAM, 0=trace disabled, else must be a power of 2
+#define COM_TRACE_RECORDS 256
+
 // Common library -----------------------------------------
 
 void BlinkLed(uint8_t led_gpio, unsigned int period, unsigned int time_on, bool restart);
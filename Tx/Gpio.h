@@ -37,6 +37,11 @@
 // #define SPI_MISO_GPIO 19 // default
 // #define SPI_MOSI_GPIO 23 // default
 
+// Optional second radio used by Rx for antenna diversity, 0 if not used
+// it shares the SCK, MISO and MOSI gpios with the first radio
+#define SPI_CE2_GPIO 0 // eg 22
+#define SPI_CS2_GPIO 0 // eg 21
+
 #define POWERSENSOR_GPIO 4 // battery voltage sensor used only in Rx/User.cpp for now, will be implemented in Tx later
 
 // User-defined GPIOs --------------------------------------
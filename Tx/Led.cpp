@@ -0,0 +1,141 @@
+/* This program is published under the GNU General Public License. 
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL 
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/******************************************************************************
+* WARNING: This file is part of the nRF24L01-FHSS project base code
+* and user should not modify it. Any user code stored in this file could be
+* made inoperable by subsequent releases of the project.
+******************************************************************************/
+
+#include "Led.h"
+
+// Configure the gpio and create the timer, the led is off
+// gpio : 0=no led, the other methods do nothing
+// return value: true=success, false=out of memory
+bool Led::Begin(uint8_t gpio) {
+	mGpio=gpio;
+	if (mGpio==0)
+		return true;
+	pinMode(mGpio, OUTPUT);
+	mMutex=xSemaphoreCreateMutex();
+	esp_timer_create_args_t timer_args={};
+	timer_args.callback=timer_callback;
+	timer_args.arg=this;
+	timer_args.dispatch_method=ESP_TIMER_TASK;
+	timer_args.name="Led";
+	if (mMutex==NULL || esp_timer_create(&timer_args, &mTimer)!=ESP_OK) {
+		mGpio=0;
+		return false;
+	}
+	mLevel=LOW;
+	digitalWrite(mGpio, mLevel);
+	return true;
+}
+
+void Led::On(void) {
+	set_steady(HIGH);
+}
+
+void Led::Off(void) {
+	set_steady(LOW);
+}
+
+// Blink the led continuously
+// period : time the led is on + time the led is off, in ms
+// time_on : time the led is on, in ms
+void Led::Blink(unsigned int period, unsigned int time_on) {
+	if (time_on==0)
+		Off();
+	else if (time_on>=period)
+		On();
+	else {
+		uint16_t steps[2]={(uint16_t)time_on, (uint16_t)(period-time_on)};
+		set_pattern(steps, 2, true);
+	}
+}
+
+// Flash the led once, a flash in progress is not restarted
+// time_on : time the led is on, in ms
+void Led::Flash(unsigned int time_on) {
+	if (time_on) {
+		uint16_t steps[1]={(uint16_t)time_on};
+		set_pattern(steps, 1, false);
+	}
+}
+
+// Flash the led count times then pause, and so on : count=0 turns off the led
+// time_on, time_off : duration of each flash and of the interval between 2 flashes, in ms
+// pause : time the led is off after the last flash, in ms
+void Led::ErrorCode(uint8_t count, unsigned int time_on, unsigned int time_off, unsigned int pause) {
+	if (count==0) {
+		Off();
+		return;
+	}
+	uint16_t steps[MAXSTEPS];
+	count=min(count, (uint8_t)(MAXSTEPS/2));
+	for (uint8_t idx=0; idx<count; idx++) {
+		steps[2*idx]=time_on;
+		steps[2*idx+1]=time_off;
+	}
+	steps[2*count-1]=pause;
+	set_pattern(steps, 2*count, true);
+}
+
+// Start the given pattern with the led on, unless the same pattern is already running
+void Led::set_pattern(const uint16_t *steps, uint8_t step_count, bool repeat) {
+	if (mGpio==0)
+		return;
+	xSemaphoreTake(mMutex, portMAX_DELAY);
+	if (!(mRunning && step_count==mStepCount && repeat==mRepeat && memcmp(steps, mSteps, step_count*sizeof(uint16_t))==0)) {
+		esp_timer_stop(mTimer);
+		memcpy(mSteps, steps, step_count*sizeof(uint16_t));
+		mStepCount=step_count;
+		mRepeat=repeat;
+		mRunning=true;
+		mStep=0;
+		mLevel=HIGH;
+		digitalWrite(mGpio, mLevel);
+		esp_timer_start_once(mTimer, mSteps[0]*1000ULL);
+	}
+	xSemaphoreGive(mMutex);
+}
+
+void Led::set_steady(bool level) {
+	if (mGpio==0)
+		return;
+	xSemaphoreTake(mMutex, portMAX_DELAY);
+	if (mStepCount || mLevel!=level) {
+		esp_timer_stop(mTimer);
+		mStepCount=0;
+		mRunning=false;
+		mLevel=level;
+		digitalWrite(mGpio, mLevel);
+	}
+	xSemaphoreGive(mMutex);
+}
+
+// runs in the esp_timer task at the end of each step
+void Led::timer_callback(void *arg) {
+	Led *led_obj=(Led *)arg;
+	xSemaphoreTake(led_obj->mMutex, portMAX_DELAY);
+	// the pattern may have been replaced while this callback was waiting for the mutex
+	if (led_obj->mRunning && led_obj->mStepCount && !esp_timer_is_active(led_obj->mTimer)) {
+		led_obj->mStep++;
+		if (led_obj->mStep==led_obj->mStepCount) {
+			led_obj->mStep=0;
+			if (!led_obj->mRepeat)
+				led_obj->mRunning=false; // complete, the led stays off
+		}
+		led_obj->mLevel=(led_obj->mRunning && led_obj->mStep%2==0) ? HIGH : LOW;
+		digitalWrite(led_obj->mGpio, led_obj->mLevel);
+		if (led_obj->mRunning)
+			esp_timer_start_once(led_obj->mTimer, led_obj->mSteps[led_obj->mStep]*1000ULL);
+	}
+	xSemaphoreGive(led_obj->mMutex);
+}
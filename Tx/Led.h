@@ -0,0 +1,57 @@
+/* This program is published under the GNU General Public License. 
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL 
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/******************************************************************************
+* WARNING: This file is part of the nRF24L01-FHSS project base code
+* and user should not modify it. Any user code stored in this file could be
+* made inoperable by subsequent releases of the project.
+******************************************************************************/
+
+#pragma once
+#include <Arduino.h>
+#include <esp_timer.h>
+
+/* Led pattern engine
+   each Led object drives one led with its own one-shot esp_timer : the timer callback switches the led
+   and rearms the timer for the next step of the pattern, so that a blinking led costs no CPU time in loop()
+   a pattern is a list of durations in ms, the led is on during the even steps and off during the odd steps
+   the methods may be called repeatedly with the same arguments : the running pattern is not restarted
+   Example:
+	Led RunLed_obj;
+	RunLed_obj.Begin(RUNLED_GPIO);
+	RunLed_obj.Blink(500, 200);  // 2 Hz
+	RunLed_obj.ErrorCode(3);     // 3 flashes, a pause, and so on
+*/
+class Led {
+	public:
+		static const uint8_t MAXSTEPS=16; // ErrorCode() accepts up to MAXSTEPS/2 flashes
+
+	private:
+		uint8_t mGpio=0; // 0=no led, all methods do nothing
+		esp_timer_handle_t mTimer=NULL;
+		SemaphoreHandle_t mMutex=NULL; // shared with the esp_timer task
+		uint16_t mSteps[MAXSTEPS];
+		uint8_t mStepCount=0; // 0=the led is steady
+		uint8_t mStep=0;      // index of the current step
+		bool mRepeat=false;
+		bool mRunning=false;  // false when a pattern which does not repeat is complete
+		bool mLevel=LOW;
+
+		void set_pattern(const uint16_t *steps, uint8_t step_count, bool repeat);
+		void set_steady(bool level);
+		static void timer_callback(void *arg);
+
+	public:
+		bool Begin(uint8_t gpio);
+		void On(void);
+		void Off(void);
+		void Blink(unsigned int period, unsigned int time_on);
+		void Flash(unsigned int time_on);
+		void ErrorCode(uint8_t count, unsigned int time_on=200, unsigned int time_off=300, unsigned int pause=1500);
+};
@@ -0,0 +1,30 @@
+/* This program is published under the GNU General Public License.
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+#pragma once
+#include "Common.h"
+#include "Schema.h"
+
+// Layout of the user data exchanged by Tx and Rx, see Schema.h
+// this file is shared by Tx and Rx so that both sides always pack and unpack the same layout
+
+// User may add code after this line ------------------------------------------
+
+// Example code: 4 servo pulses and 2 switches states sent by Tx
+typedef Channel<uint16_t, 500, 2500> ServoPulse; // µs, 11 bits, range copied from ESP32Servo.h
+typedef Channel<uint8_t, 0, 1> SwitchState;      // 1 bit
+using MsgSchema=Schema<ServoPulse, ServoPulse, ServoPulse, ServoPulse, SwitchState, SwitchState>;
+
+// Example code: Rx error count and power supply voltage sent back by Rx
+typedef Channel<uint16_t, 0, 1023> ErrorCount;   // missing datagrams per second, 10 bits
+typedef Channel<uint16_t, 0, 16383> Millivolts;  // mV, 14 bits
+using AckSchema=Schema<ErrorCount, Millivolts>;
+
+static_assert(MsgSchema::WORDS<=COM_MSGVALUES, "MsgSchema does not fit in COM_MSGVALUES, see Common.h");
+static_assert(AckSchema::WORDS<=COM_ACKVALUES, "AckSchema does not fit in COM_ACKVALUES, see Common.h");
@@ -0,0 +1,207 @@
+/* This program is published under the GNU General Public License. 
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL 
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/******************************************************************************
+* WARNING: This file is part of the nRF24L01-FHSS project base code
+* and user should not modify it. Any user code stored in this file could be
+* made inoperable by subsequent releases of the project.
+******************************************************************************/
+
+#include "Mixer.h"
+#include <math.h>
+#include <string.h>
+#include <rgCsv.h>
+
+// 0=debug off, 1=output to serial, 2=output to serial and optionally bluetooth with dbtprintln()
+#define DEBUG_ON 1
+// 0=trace off, 1=output to serial, 2=output to serial and optionally bluetooth with trbtprintln()
+#define TRACE_ON 0
+#include <rgDebug.h>
+
+// a value missing or not an integer in a row of MIXFILE
+static const int32_t NO_VALUE=INT32_MIN;
+
+// Read an integer cell of a row of MIXFILE, default_value is used if the cell is missing or empty
+// return value: true=success, false=the cell is not an integer
+static bool get_value(rgCsvRows *row, int column, int32_t default_value, int32_t *value_out) {
+	int32_t value=row->GetInt(column, NO_VALUE);
+	if (value==NO_VALUE) {
+		const char *cell_str=row->GetStr(column);
+		if (cell_str && *cell_str)
+			return false;
+		value=default_value;
+	}
+	*value_out=value;
+	return true;
+}
+
+/*  Read MIXFILE and precompute the curves, call it at boot after Settings::Init()
+	Return value: 0=success, <0 the default mixer is used :
+	-1	filesystem not found
+	-2	MIXFILE not found
+	-3	line too long or missing newline
+	-4	too many cells
+	-5	invalid row
+*/
+int Mixer::Load(void) {
+	set_defaults();
+	rgCsvRows rows_obj;
+	int retval=rows_obj.Open(MIXFILE);
+	if (retval<0)
+		return retval;
+
+	// the MIX rows of an output replace its default weights, the outputs without MIX row keep them
+	bool mixed[MAXOUTPUTS]={false};
+	int count;
+	while ((count=rows_obj.Next())>0) {
+		retval=parse_row(&rows_obj, mixed);
+		if (retval<0)
+			break;
+	}
+	if (count<0)
+		retval=count;
+	if (retval<0) {
+		dbprintf("%s: error %d line %d, using the default mixer\n", MIXFILE, retval, rows_obj.Line());
+		set_defaults();
+	}
+	rows_obj.Close();
+	return retval;
+}
+
+/* Compute the outputs, called for each MSG datagram
+	inputs	MAXINPUTS values -UNIT..UNIT, the values out of this range are limited
+	outputs	MAXOUTPUTS values, limited to their min and max
+*/
+void Mixer::Compute(const int16_t *inputs, int16_t *outputs) {
+	int32_t curved[MAXINPUTS];
+	for (uint8_t input=0; input<MAXINPUTS; input++) {
+		int32_t position=inputs[input]+UNIT;
+		position=position<0 ? 0 : position;                   // compiled as min/max instructions
+		position=position>2*UNIT ? 2*UNIT : position;
+		const int16_t *lut=mCurves[input]+(position>>LUT_SHIFT);
+		int32_t fraction=position&((1<<LUT_SHIFT)-1);
+		curved[input]=lut[0]+(((lut[1]-lut[0])*fraction)>>LUT_SHIFT);
+	}
+	for (uint8_t output=0; output<MAXOUTPUTS; output++) {
+		int32_t sum=0;
+		for (uint8_t input=0; input<MAXINPUTS; input++)
+			sum+=mWeights[output][input]*curved[input];
+		sum=(sum>>UNIT_SHIFT)+mSubtrim[output];
+		sum=sum<mMin[output] ? mMin[output] : sum;
+		sum=sum>mMax[output] ? mMax[output] : sum;
+		outputs[output]=sum;
+	}
+}
+
+// convert value in min_value..max_value to -UNIT..UNIT, not limited
+int16_t Mixer::Normalize(int32_t value, int32_t min_value, int32_t max_value) {
+	return (value-min_value)*2*UNIT/(max_value-min_value)-UNIT;
+}
+
+// convert value in -UNIT..UNIT to min_value..max_value, not limited
+int32_t Mixer::Denormalize(int16_t value, int32_t min_value, int32_t max_value) {
+	return min_value+(value+UNIT)*(max_value-min_value)/(2*UNIT);
+}
+
+/* Private implementation ****************************************************/
+
+// each output is equal to the input with the same number
+void Mixer::set_defaults(void) {
+	memset(mWeights, 0, sizeof(mWeights));
+	for (uint8_t idx=0; idx<MAXINPUTS; idx++)
+		build_curve(idx, NULL, 1, 0, 0);
+	for (uint8_t idx=0; idx<MAXOUTPUTS; idx++) {
+		if (idx<MAXINPUTS)
+			mWeights[idx][idx]=UNIT;
+		mMin[idx]=-UNIT;
+		mMax[idx]=UNIT;
+		mSubtrim[idx]=0;
+	}
+}
+
+/* Precompute the curve of an input, in floating point : this is done only when MIXFILE is loaded
+	points	CURVE_POINTS values -1..1, or NULL to use rate and expo
+	rate	-2..2
+	expo	0..1, output=rate*(expo*x^3+(1-expo)*x)
+	trim	-1..1, added to the output
+*/
+void Mixer::build_curve(uint8_t input, const float *points, float rate, float expo, float trim) {
+	for (uint8_t idx=0; idx<=LUT_SEGMENTS; idx++) {
+		float x=(float)idx*2/LUT_SEGMENTS-1; // -1..1
+		float y;
+		if (points) {
+			// linear interpolation between the points
+			float position=(x+1)*(CURVE_POINTS-1)/2;
+			uint8_t point=position>=CURVE_POINTS-1 ? CURVE_POINTS-2 : (uint8_t)position;
+			y=points[point]+(points[point+1]-points[point])*(position-point);
+		}
+		else
+			y=rate*(expo*x*x*x+(1-expo)*x);
+		int32_t value=lroundf((y+trim)*UNIT);
+		value=value<INT16_MIN ? INT16_MIN : value;
+		value=value>INT16_MAX ? INT16_MAX : value;
+		mCurves[input][idx]=value;
+	}
+	mCurves[input][LUT_SEGMENTS+1]=mCurves[input][LUT_SEGMENTS];
+}
+
+// Parse a row of MIXFILE
+// mixed[output] is set by the first MIX row of the output, which clears its default weights
+// return value: 0=success, -5=invalid row or value not an integer
+int Mixer::parse_row(rgCsvRows *row, bool *mixed) {
+	const char *type_str=row->GetStr(0);
+	int32_t number=row->GetInt(1, NO_VALUE)-1;
+	if (type_str==NULL || number<0 || number>=(strcmp(type_str, "OUTPUT")==0 || strcmp(type_str, "MIX")==0 ? MAXOUTPUTS : MAXINPUTS))
+		return -5;
+
+	if (strcmp(type_str, "INPUT")==0) {
+		int32_t rate, expo, trim;
+		if (!get_value(row, 2, 100, &rate) || !get_value(row, 3, 0, &expo) || !get_value(row, 4, 0, &trim))
+			return -5;
+		if (rate<-200 || rate>200 || expo<0 || expo>100 || trim<-100 || trim>100)
+			return -5;
+		build_curve(number, NULL, rate/100.0f, expo/100.0f, trim/100.0f);
+	}
+	else if (strcmp(type_str, "CURVE")==0) {
+		float points[CURVE_POINTS];
+		if (row->Count()!=CURVE_POINTS+2)
+			return -5;
+		for (uint8_t idx=0; idx<CURVE_POINTS; idx++) {
+			int32_t point=row->GetInt(idx+2, NO_VALUE);
+			if (point<-100 || point>100)
+				return -5;
+			points[idx]=point/100.0f;
+		}
+		build_curve(number, points, 1, 0, 0);
+	}
+	else if (strcmp(type_str, "MIX")==0) {
+		int32_t input=row->GetInt(2, NO_VALUE)-1;
+		int32_t weight=row->GetInt(3, NO_VALUE);
+		if (input<0 || input>=MAXINPUTS || weight<-200 || weight>200)
+			return -5;
+		if (!mixed[number]) {
+			memset(mWeights[number], 0, sizeof(mWeights[number]));
+			mixed[number]=true;
+		}
+		mWeights[number][input]=weight*UNIT/100;
+	}
+	else if (strcmp(type_str, "OUTPUT")==0) {
+		int32_t min_value, max_value, subtrim;
+		if (!get_value(row, 2, -100, &min_value) || !get_value(row, 3, 100, &max_value) || !get_value(row, 4, 0, &subtrim))
+			return -5;
+		if (min_value<-150 || max_value>150 || min_value>max_value || subtrim<-100 || subtrim>100)
+			return -5;
+		mMin[number]=min_value*UNIT/100;
+		mMax[number]=max_value*UNIT/100;
+		mSubtrim[number]=subtrim*UNIT/100;
+	}
+	else
+		return -5;
+	return 0;
+}
@@ -0,0 +1,69 @@
+/* This program is published under the GNU General Public License. 
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL 
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/******************************************************************************
+* WARNING: This file is part of the nRF24L01-FHSS project base code
+* and user should not modify it. Any user code stored in this file could be
+* made inoperable by subsequent releases of the project.
+******************************************************************************/
+
+#pragma once
+#include <stdint.h>
+
+class rgCsvRows;
+
+/* Channel mixer with rates, expo, custom curves, trims and limits, in fixed point
+   the inputs and the outputs are normalized to -UNIT..UNIT (-100%..100%)
+   Load() reads MIXFILE and precomputes the curve of each input into a lookup table, including its rate, expo and trim ;
+   Compute() evaluates the curves by linear interpolation in the tables, then the weighted matrix, then the limits :
+   integer arithmetic only, and no branch depending on the values
+   
+   file mixer.csv, all the values are in percent, the inputs and outputs are numbered from 1
+	# Channel mixer
+	# INPUT,<input>,<rate>,<expo>,<trim>      rate -200..200 (default 100), expo 0..100 (default 0), trim -100..100 (default 0)
+	# CURVE,<input>,<9 points>                custom curve, points at -100,-75,...,100 %, replaces the rate and the expo
+	# MIX,<output>,<input>,<weight>           weight -200..200, an output is the sum of its weighted inputs,
+	#                                         an output without MIX row is equal to the input with the same number
+	# OUTPUT,<output>,<min>,<max>,<subtrim>   limits -150..150 (default -100,100), subtrim -100..100 (default 0)
+	INPUT,1,100,30,0
+	MIX,1,1,100
+	MIX,2,2,50
+	MIX,2,3,50
+   if MIXFILE does not exist, or if it contains an error, each output is equal to the input with the same number
+*/
+class Mixer {
+	public:
+		static const uint8_t UNIT_SHIFT=10;
+		static const int32_t UNIT=1<<UNIT_SHIFT; // 100%
+		static const uint8_t MAXINPUTS=8;
+		static const uint8_t MAXOUTPUTS=8;
+		static const uint8_t CURVE_POINTS=9; // points of a custom curve given in MIXFILE
+		const char *MIXFILE="/mixer.csv";
+
+	private:
+		static const uint8_t LUT_SHIFT=6;                    // 64 input units per segment
+		static const uint8_t LUT_SEGMENTS=2*UNIT>>LUT_SHIFT; // 32
+		// one more entry than the points, so that the input UNIT does not need a special case
+		int16_t mCurves[MAXINPUTS][LUT_SEGMENTS+2];
+		int16_t mWeights[MAXOUTPUTS][MAXINPUTS]; // fixed point, UNIT=100%
+		int16_t mMin[MAXOUTPUTS];
+		int16_t mMax[MAXOUTPUTS];
+		int16_t mSubtrim[MAXOUTPUTS];
+
+		void set_defaults(void);
+		void build_curve(uint8_t input, const float *points, float rate, float expo, float trim);
+		int parse_row(rgCsvRows *row, bool *mixed);
+
+	public:
+		int Load(void);
+		void Compute(const int16_t *inputs, int16_t *outputs);
+		// conversions between a range and -UNIT..UNIT, eg ADC values or servo pulses
+		static int16_t Normalize(int32_t value, int32_t min_value, int32_t max_value);
+		static int32_t Denormalize(int16_t value, int32_t min_value, int32_t max_value);
+};
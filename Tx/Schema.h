@@ -0,0 +1,143 @@
+/* This program is published under the GNU General Public License.
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/******************************************************************************
+* WARNING: This file is part of the nRF24L01-FHSS project base code
+* and user should not modify it. Any user code stored in this file could be
+* made inoperable by subsequent releases of the project.
+******************************************************************************/
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <utility> // for std::index_sequence
+
+/* Compile-time description of the user data carried by a datagram
+   A Schema is a list of Channels, each channel is packed into the smallest number of bits that holds its range,
+   and the channels are packed one after the other into the uint16_t message array of the datagram.
+   Pack() and Unpack() are generated by the compiler for each schema : all bit offsets and masks are constants
+   Example:
+       typedef Channel<uint16_t, 500, 2500> ServoPulse; // 11 bits
+       typedef Channel<bool, 0, 1> Switch;               // 1 bit
+       using MsgSchema=Schema<ServoPulse, ServoPulse, Switch>;
+       MsgSchema::Pack(message, 1500, 2000, true);      // 23 bits stored in message[0] and message[1]
+       MsgSchema::Unpack(message, pulse1, pulse2, sw);
+   See Message.h for the schemas used by the example code
+*/
+
+// number of bits needed to store the values 0 to range
+constexpr uint8_t SchemaBits(uint32_t range) {
+    uint8_t bits=1;
+    while (bits<32 && (range>>bits))
+        bits++;
+    return bits;
+}
+
+// A channel carries values of type T in the range LOWEST-HIGHEST
+// BITS defaults to the smallest width holding the whole range, a smaller width quantizes the values
+// out of range values are clamped to LOWEST or HIGHEST
+template <typename T, int32_t LOWEST, int32_t HIGHEST, uint8_t BITS=SchemaBits(HIGHEST-LOWEST)>
+struct Channel {
+    static_assert(LOWEST<HIGHEST, "Channel LOWEST must be smaller than HIGHEST");
+    static_assert(BITS>=1 && BITS<=16, "Channel BITS must be in the range 1-16");
+
+    typedef T type;
+    static constexpr int32_t MIN_VALUE=LOWEST;
+    static constexpr int32_t MAX_VALUE=HIGHEST;
+    static constexpr uint8_t WIDTH=BITS;
+    static constexpr uint32_t MASK=(1UL<<BITS)-1;
+    static constexpr uint32_t RANGE=(uint32_t)(HIGHEST-LOWEST);
+
+    static inline uint32_t Encode(T value) {
+        int32_t clamped=(int32_t)value;
+        clamped=clamped<LOWEST ? LOWEST : clamped; // compiled to MIN/MAX instructions, no branch
+        clamped=clamped>HIGHEST ? HIGHEST : clamped;
+        uint32_t offset=(uint32_t)(clamped-LOWEST);
+        if constexpr (RANGE<=MASK)
+            return offset; // exact
+        else
+            return (uint32_t)(((uint64_t)offset*MASK+RANGE/2)/RANGE); // quantized, divides by a constant
+    }
+
+    // a raw value above RANGE (corrupted datagram, or sent by a newer schema) is clamped to HIGHEST
+    static inline T Decode(uint32_t raw) {
+        if constexpr (RANGE<=MASK)
+            return (T)(LOWEST+(int32_t)(raw>RANGE ? RANGE : raw));
+        else
+            return (T)(LOWEST+(int32_t)(((uint64_t)raw*RANGE+MASK/2)/MASK));
+    }
+};
+
+template <typename... CHANNELS>
+class Schema {
+    public:
+        static constexpr uint8_t COUNT=sizeof...(CHANNELS);
+        static constexpr uint16_t BITS=(CHANNELS::WIDTH + ... + 0);
+        // number of uint16_t values of the message array used by this schema
+        static constexpr uint8_t WORDS=(BITS+15)/16;
+
+        // the datagram (number, type, message) must fit in the 32 bytes payload of the nRF24
+        static constexpr uint8_t PAYLOAD_SIZE=32;
+        static constexpr uint8_t HEADER_SIZE=2*sizeof(uint16_t);
+        static_assert(HEADER_SIZE+WORDS*sizeof(uint16_t)<=PAYLOAD_SIZE, "Schema does not fit in the 32 bytes payload");
+
+        // Store the given values into message[0] to message[WORDS-1], the other values of message are not modified
+        static inline void Pack(uint16_t *message, typename CHANNELS::type... values) {
+            for (uint8_t idx=0; idx<WORDS; idx++)
+                message[idx]=0;
+            pack(message, std::index_sequence_for<CHANNELS...>{}, values...);
+        }
+
+        // Extract the values stored by Pack() into the given variables
+        static inline void Unpack(const uint16_t *message, typename CHANNELS::type &... values_out) {
+            unpack(message, std::index_sequence_for<CHANNELS...>{}, values_out...);
+        }
+
+    private:
+        static constexpr uint8_t WIDTHS[]={CHANNELS::WIDTH...};
+
+        // bit offset of channel number index
+        static constexpr uint16_t offset(uint8_t index) {
+            uint16_t retval=0;
+            for (uint8_t idx=0; idx<index; idx++)
+                retval+=WIDTHS[idx];
+            return retval;
+        }
+
+        // a channel is at most 16 bits wide, so it spans at most 2 values of message
+        template <uint16_t OFFSET, uint8_t WIDTH>
+        static inline void put(uint16_t *message, uint32_t raw) {
+            constexpr uint8_t WORD=OFFSET/16;
+            constexpr uint8_t SHIFT=OFFSET%16;
+            uint32_t bits=raw<<SHIFT;
+            message[WORD]|=(uint16_t)bits;
+            if constexpr (SHIFT+WIDTH>16)
+                message[WORD+1]|=(uint16_t)(bits>>16);
+        }
+
+        template <uint16_t OFFSET, uint8_t WIDTH>
+        static inline uint32_t get(const uint16_t *message) {
+            constexpr uint8_t WORD=OFFSET/16;
+            constexpr uint8_t SHIFT=OFFSET%16;
+            uint32_t bits=message[WORD]>>SHIFT;
+            if constexpr (SHIFT+WIDTH>16)
+                bits|=(uint32_t)message[WORD+1]<<(16-SHIFT);
+            return bits & ((1UL<<WIDTH)-1);
+        }
+
+        template <size_t... INDEX>
+        static inline void pack(uint16_t *message, std::index_sequence<INDEX...>, typename CHANNELS::type... values) {
+            (put<offset(INDEX), CHANNELS::WIDTH>(message, CHANNELS::Encode(values)), ...);
+        }
+
+        template <size_t... INDEX>
+        static inline void unpack(const uint16_t *message, std::index_sequence<INDEX...>, typename CHANNELS::type &... values_out) {
+            ((values_out=CHANNELS::Decode(get<offset(INDEX), CHANNELS::WIDTH>(message))), ...);
+        }
+};
@@ -16,9 +16,12 @@
 #include "Settings.h"
 #include "Common.h"
 #include <rgBtn.h>
+#include <Preferences.h> // NVS
+#include <esp_rom_crc.h>
 
 // 0=debug off, 1=output to serial, 2=output to serial and optionally bluetooth with dbtprintln()
-#define DEBUG_ON 1
+// 3=deferred output to serial, Flush() runs in the radio task of Rx (see rgDebug.h)
+#define DEBUG_ON 3
 // 0=trace off, 1=output to serial, 2=output to serial and optionally bluetooth with trbtprintln()
 #define TRACE_ON 0
 #include <rgDebug.h>
@@ -26,20 +29,17 @@
 /*****************************************
 * Application parameters file param.csv
 *****************************************/
-enum class Paramid {
-	TXID,
-	RXID,
-	MONOCHAN,
-	PALEVEL
-};
-rgCsv ParamCsv_obj;
-// we use these macros to simplify access to the mCells array of ParamCsv_obj
-#define PARAMGETSTR(x)		GetStrCell((byte)Paramid::x, 0)
-#define PARAMSETSTR(x,v)	SetStrCell((byte)Paramid::x, 0, (v))
-#define PARAMGETINT(x)		GetIntCell((byte)Paramid::x, 1)
-#define PARAMSETINT(x,v)	SetIntCell((byte)Paramid::x, 1, (v))
-
-// Mount the filesystem and read current settings from PARFILE
+// the keys of the parameters, in the order of the lines of the settings files created before the keyed mode
+// these files contain "0" instead of the keys, their lines are identified by their position
+// indexed by Settings::ParamIndex
+static const char *Param_keys[]={"TXID", "RXID", "MONOCHAN", "PALEVEL"};
+
+// NVS namespace and key of the snapshot
+static const char *SNAPSHOT_NAMESPACE="settings";
+static const char *SNAPSHOT_KEY="snapshot";
+
+// Read current settings from the snapshot, or from PARFILE if it has been modified since the snapshot was written
+// the file system must be mounted
 // PARFILE will be created if not found
 // PARFILE will be overwritten with default values if the given button is pressed long enough
 // return value: 0=ok, not 0 on error :
@@ -56,11 +56,20 @@ int Settings::Init(
 ) {
 	trprintf("*** %s %s() begin\n", __FILE_NAME__, __FUNCTION__);
 	int retval=0;
+
+	// fast boot : PARFILE is not parsed if it has not changed
+	if (load_snapshot()) {
+		dbprint("Settings snapshot : "); // 2 records, a record holds RGLOG_RECORD_SIZE characters
+		dbprintf("TxId 0x%06x (%d), RxId 0x%06x (%d), Chan 0x%02x (%d), Pa_level %d\n",
+			GetTxDeviceId(), GetTxDeviceId(), GetRxDeviceId(), GetRxDeviceId(), GetMonoChannel(), GetMonoChannel(), GetPaLevel());
+		trprintf("*** %s %s() returns %d\n", __FILE_NAME__, __FUNCTION__, retval);
+		return retval;
+	}
 	
 	// Mount the file system and allocate memory for the file
 	bool create_settings_file=false;
 	int nrecords=0;
-	switch (Allocate(PARFILE, PAR_MAXLINES, PAR_MAXCELLS, PAR_MAXCELLEN, false)) {
+	switch (Allocate(PARFILE, PAR_MAXLINES, PAR_MAXCELLS, PAR_MAXCELLEN, false, true)) {
 	case 0:
 		/*  Load the whole file in RAM
 			Load() return value : number of key/value pairs found, or a negative value on error
@@ -73,10 +82,12 @@ int Settings::Init(
 		*/
 		nrecords=Load(); // returns the number of csv data lines found, or a negative value on error 
 		if (nrecords>0) { 
+			Loaded=true;
+			retval=upgrade_settings(nrecords, default_tx_deviceid, default_rx_deviceid, default_mono_chan, default_pa_level);
+			read_values();
 			dbprintf("%s contains %d records : ", PARFILE, nrecords);
 			dbprintf("TxId 0x%06x (%d), RxId 0x%06x (%d), Chan 0x%02x (%d), Pa_level %d\n", 
 				GetTxDeviceId(), GetTxDeviceId(), GetRxDeviceId(), GetRxDeviceId(), GetMonoChannel(), GetMonoChannel(), GetPaLevel());
-			retval=0;
 		}
 		else if (nrecords==0) {
 			dbprintln("Init: settings file is empty");
@@ -112,59 +123,201 @@ int Settings::Init(
 		Release();
 		retval=create_settings(default_tx_deviceid, default_rx_deviceid, default_mono_chan, default_pa_level);
 	}
+	if (retval==0)
+		save_snapshot(); // PARFILE has changed or has just been created, or the snapshot was missing
 	
 	trprintf("*** %s %s() returns %d\n", __FILE_NAME__, __FUNCTION__, retval);
     return retval;
 }
 
 int Settings::GetTxDeviceId(void) {
-	return PARAMGETINT(TXID);
+	return Values[PAR_TXID];
 }
 
 bool Settings::SetTxDeviceId(int value) {
-	bool retval=true;
-	if (PARAMSETINT(TXID, value)<0)  {
-		dbprintln("TXID write error");
-		retval=false;
-	}
-	return retval;
+	return set_param(PAR_TXID, value);
 }
 
 int Settings::GetRxDeviceId(void) {
-	return PARAMGETINT(RXID);
+	return Values[PAR_RXID];
 }
 
 bool Settings::SetRxDeviceId(int value) {
-	bool retval=true;
-	if (PARAMSETINT(RXID, value)<0)  {
-		dbprintln("RXID write error");
-		retval=false;
-	}
-	return retval;
+	return set_param(PAR_RXID, value);
 }
 
 int Settings::GetMonoChannel() {
-	return PARAMGETINT(MONOCHAN);
+	return Values[PAR_MONOCHAN];
 }
 
 bool Settings::SetMonoChannel(int value) {
-	bool retval=true;
-	if (PARAMSETINT(MONOCHAN, value)<0)  {
-		dbprintln("MONOCHAN write error");
-		retval=false;
-	}
-	return retval;
+	return set_param(PAR_MONOCHAN, value);
 }
 
 int Settings::GetPaLevel() {
-	return PARAMGETINT(PALEVEL);
+	return Values[PAR_PALEVEL];
 }
 
 bool Settings::SetPaLevel(int value) {
-	bool retval=true;
-	if (PARAMSETINT(PALEVEL, value)<0)  {
-		dbprintln("PALEVEL write error");
-		retval=false;
+	return set_param(PAR_PALEVEL, value);
+}
+
+// the value is written to PARFILE by Save()
+// this function does not access the file system and may be called by the time critical code
+// return value: true=success
+bool Settings::set_param(ParamIndex index, int value) {
+	Values[index]=value;
+	return true;
+}
+
+/* Write the settings to PARFILE
+   PARFILE is loaded first if the settings were read from the snapshot at boot
+   rgCsv::Save() writes the file only if a setting has been modified
+   the snapshot is not written here, Save() may be called by Flush() in the gap between 2 datagrams :
+   its CRC no longer matches the modified PARFILE, so Init() parses PARFILE and rewrites the snapshot at next boot
+   return value: number of lines written, negative value on error (see rgCsv::Save(), -4=PARFILE load error)
+*/
+int Settings::Save(void) {
+	int retval=0;
+	if (load_file()<0)
+		return -4;
+	for (int idx=0; idx<PAR_COUNT && retval>=0; idx++) {
+		if (SetInt(Param_keys[idx], Values[idx])<0) {
+			dbprintf("%s write error\n", Param_keys[idx]);
+			retval=-2;
+		}
+	}
+	if (retval>=0)
+		retval=rgCsv::Save();
+	return retval;
+}
+
+// copy the values of PARFILE to Values[]
+void Settings::read_values(void) {
+	for (int idx=0; idx<PAR_COUNT; idx++)
+		Values[idx]=GetInt(Param_keys[idx]);
+}
+
+// load PARFILE in RAM if it was not loaded by Init()
+// return value: 0=success, <0 Allocate() or Load() error
+int Settings::load_file(void) {
+	int retval=0;
+	if (!Loaded) {
+		retval=Allocate(PARFILE, PAR_MAXLINES, PAR_MAXCELLS, PAR_MAXCELLEN, false, true);
+		if (retval==0) {
+			retval=Load();
+			if (retval>0) {
+				Loaded=true;
+				retval=0;
+			}
+			else {
+				dbprintf("load_file: error %d loading settings file\n", retval);
+				retval=-1;
+			}
+		}
+	}
+	return retval;
+}
+
+// Read the snapshot from NVS and check that PARFILE has not been modified since it was written
+// return value: true=Values[] contains the settings, false=PARFILE must be parsed
+bool Settings::load_snapshot(void) {
+	Snapshot snapshot;
+	Preferences preferences_obj;
+	if (!preferences_obj.begin(SNAPSHOT_NAMESPACE, true)) // read-only
+		return false;
+	size_t size=preferences_obj.getBytes(SNAPSHOT_KEY, &snapshot, sizeof(snapshot));
+	preferences_obj.end();
+	if (size!=sizeof(snapshot) || snapshot.version!=SNAPSHOT_VERSION || snapshot.size!=sizeof(snapshot))
+		return false;
+	if (snapshot.crc!=esp_rom_crc32_le(0, (const uint8_t *)&snapshot, offsetof(Snapshot, crc)))
+		return false; // corrupted
+	if (snapshot.csv_crc!=file_crc())
+		return false; // PARFILE has been modified, deleted or created
+	memcpy(Values, snapshot.values, sizeof(Values));
+	return true;
+}
+
+// Write Values[] and the CRC of PARFILE to NVS
+void Settings::save_snapshot(void) {
+	Snapshot snapshot;
+	memset(&snapshot, 0, sizeof(snapshot));
+	snapshot.version=SNAPSHOT_VERSION;
+	snapshot.size=sizeof(snapshot);
+	snapshot.csv_crc=file_crc();
+	memcpy(snapshot.values, Values, sizeof(Values));
+	snapshot.crc=esp_rom_crc32_le(0, (const uint8_t *)&snapshot, offsetof(Snapshot, crc));
+	Preferences preferences_obj;
+	if (preferences_obj.begin(SNAPSHOT_NAMESPACE, false)) {
+		if (preferences_obj.putBytes(SNAPSHOT_KEY, &snapshot, sizeof(snapshot))!=sizeof(snapshot))
+			dbprintln("save_snapshot: NVS write error");
+		preferences_obj.end();
+	}
+	else
+		dbprintln("save_snapshot: NVS not available");
+}
+
+// return value: CRC of the contents of PARFILE, 0 if not found
+uint32_t Settings::file_crc(void) {
+	uint32_t retval=0;
+	File file_obj=LittleFS.open(PARFILE, "r");
+	if (file_obj) {
+		uint8_t buffer[128];
+		int count;
+		while ((count=file_obj.read(buffer, sizeof(buffer)))>0)
+			retval=esp_rom_crc32_le(retval, buffer, count);
+		file_obj.close();
+	}
+	return retval;
+}
+
+// Add the keys missing in a settings file created by a previous release
+// the lines without a key are identified by their position, the missing parameters are added with their default value
+// nrecords is the number of lines returned by Load()
+// return value: 0=ok, 1=settings file update failed
+int Settings::upgrade_settings(
+	int nrecords,
+	uint16_t tx_deviceid,
+	uint16_t rx_deviceid,
+	uint8_t mono_chan,
+	uint8_t pa_level
+) {
+	int retval=0;
+	const int default_values[]={tx_deviceid, rx_deviceid, mono_chan, pa_level};
+	for (int idx=0; idx<(int)(sizeof(Param_keys)/sizeof(Param_keys[0])); idx++) {
+		if (FindKey(Param_keys[idx])<0) {
+			if (idx<nrecords && GetStrCell(idx, 0)==NULL) {
+				dbprintf("upgrade_settings: key %s added to line %d\n", Param_keys[idx], idx+1);
+				SetStrCell(idx, 0, Param_keys[idx]);
+			}
+			else {
+				dbprintf("upgrade_settings: parameter %s added\n", Param_keys[idx]);
+				SetInt(Param_keys[idx], default_values[idx]);
+			}
+		}
+	}
+	if (IsDirty() && rgCsv::Save()<0) {
+		dbprintln("upgrade_settings: error saving settings file");
+		retval=1;
+	}
+	return retval;
+}
+
+// Request a deferred save of the settings, see Flush()
+// this function does not access the file system and may be called by the time critical code
+void Settings::RequestSave(void) {
+	SaveRequested=true;
+}
+
+// Save the settings if RequestSave() was called since the last Flush()
+// Save() writes the file only if a setting has been modified
+// return value: 0=nothing to save, >0 number of lines saved, <0 Save() error
+int Settings::Flush(void) {
+	int retval=0;
+	if (SaveRequested.exchange(false)) {
+		retval=Save();
+		if (retval<0)
+			dbprintf("Flush: error %d saving settings file\n", retval);
 	}
 	return retval;
 }
@@ -182,8 +335,9 @@ int Settings::create_settings(
 	int retval=0;
 
 	// Mount the file system and allocate memory for the file
-	if (Allocate(PARFILE, PAR_MAXLINES, PAR_MAXCELLS, PAR_MAXCELLEN, true)==0) {
+	if (Allocate(PARFILE, PAR_MAXLINES, PAR_MAXCELLS, PAR_MAXCELLEN, true, true)==0) {
 		dbprintln("create_settings: creating settings file...");
+		Loaded=true;
 
 		// This value uniquely identifies the transmitter
 		SetTxDeviceId(tx_deviceid);
@@ -201,13 +355,13 @@ int Settings::create_settings(
 		// Tx uses the value returned by read_pa_level_switch() and does not access this key
 		SetPaLevel(pa_level);
 
-		int nrecords=Save(4); // returns the number of lines written, negative value on error, or a negative value on error 
+		int nrecords=Save(); // returns the number of lines written, or a negative value on error
 		if (nrecords>=0) {
 			dbprintf("create_settings: settings file created with %d records\n", nrecords);
 			retval=0;
 		}
 		else {
-			dbprintln("create_settings: error %d creating settings file");
+			dbprintf("create_settings: error %d creating settings file\n", nrecords);
 			retval=1;
 		}
 	}
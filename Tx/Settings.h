@@ -14,6 +14,7 @@
 ******************************************************************************/
 
 #pragma once
+#include <atomic>
 #include <rgCsv.h>
 
 class Settings : public rgCsv {
@@ -21,18 +22,49 @@ class Settings : public rgCsv {
 		/* file param.csv
 		# Application parameters
 		# Line length 25 chr max
-		# Do not change the order
-		# of the lines
+		# the lines may be stored in any order
 		TXID,256
 		RXID,512
 		MONOCHAN,64
 		PALEVEL,0
 		*/
-		static const int PAR_MAXLINES=4;
+		static const int PAR_MAXLINES=8; // room for new parameters
 		static const int PAR_MAXCELLS=2;
 		static const int PAR_MAXCELLEN=12;
-		
+
+		// index of the parameters in Values[] and in the snapshot
+		enum ParamIndex {PAR_TXID, PAR_RXID, PAR_MONOCHAN, PAR_PALEVEL, PAR_COUNT};
+
+		// the values of the parameters, read from the snapshot or from PARFILE
+		// the setters modify these values, Save() writes them to PARFILE
+		int32_t Values[PAR_COUNT];
+		// true when PARFILE has been loaded in RAM, it is not loaded at boot if the snapshot is valid
+		bool Loaded=false;
+
+		/* Binary snapshot of the settings, stored in the NVS partition
+		   it is read in a single access at boot instead of parsing PARFILE,
+		   csv_crc is the CRC of PARFILE when the snapshot was written : PARFILE is parsed again only if it has changed
+		*/
+		static const uint16_t SNAPSHOT_VERSION=1;
+		struct Snapshot {
+			uint16_t version;
+			uint16_t size;      // sizeof(Snapshot)
+			uint32_t csv_crc;
+			int32_t values[PAR_COUNT];
+			uint32_t crc;       // CRC of the preceding fields
+		};
+
 		int create_settings(uint16_t tx_deviceid, uint16_t rx_deviceid, uint8_t mono_chan, uint8_t pa_level);
+		int upgrade_settings(int nrecords, uint16_t tx_deviceid, uint16_t rx_deviceid, uint8_t mono_chan, uint8_t pa_level);
+		bool set_param(ParamIndex index, int value);
+		void read_values(void);
+		int load_file(void);
+		bool load_snapshot(void);
+		void save_snapshot(void);
+		uint32_t file_crc(void);
+
+		// set by RequestSave(), cleared by Flush()
+		std::atomic<bool> SaveRequested{false};
 		
 	public:
 		const char *PARFILE="/param.csv";
@@ -41,11 +73,10 @@ class Settings : public rgCsv {
 		int Open(const char *path_str, int maxlines_int, int maxcells_int, int maxcellen_int);
 		void Close(void);
 		int Load(void);
-		int Save(void);
-		int16_t GetIntCell(byte line_int, byte column_int);
-		int SetIntCell(byte line_int, byte column_int, int16_t new_value_int);
-		const char *GetStrCell(byte line_int, byte column_int);
-		int SetStrCell(byte line_int, byte column_int, const char *new_value_str);
+		bool IsDirty(void);
+		int32_t GetInt(const char *key_str, int32_t default_int=-1);
+		int SetInt(const char *key_str, int32_t new_value_int);
+		...
 		*/
 		
 	    int Init(
@@ -54,6 +85,7 @@ class Settings : public rgCsv {
 			uint8_t default_mono_chan,
 			uint8_t default_pa_level
 		);
+		int Save(void);
 		int GetTxDeviceId(void);
 		bool SetTxDeviceId(int value);
 		int GetRxDeviceId(void);
@@ -64,4 +96,10 @@ class Settings : public rgCsv {
 		// used only by Rx
 		int GetPaLevel(void);
 		bool SetPaLevel(int value);
+
+		// Deferred save : the time critical code calls RequestSave() after modifying the settings,
+		// and Flush() is called in an idle gap between 2 datagrams : writing to the flash memory disables
+		// the cache of both cores, so it delays the radio code even if it runs on the other core
+		void RequestSave(void);
+		int Flush(void);
 };
@@ -0,0 +1,61 @@
+/* This program is published under the GNU General Public License.
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/******************************************************************************
+* WARNING: This file is part of the nRF24L01-FHSS project base code
+* and user should not modify it. Any user code stored in this file could be
+* made inoperable by subsequent releases of the project.
+******************************************************************************/
+
+#pragma once
+#include <atomic>
+#include <stdint.h>
+
+// Lock-free single-producer / single-consumer queue
+// one task calls Push() and one other task calls Pop(), they may run on different cores
+// neither call ever blocks : Push() fails when the queue is full and Pop() fails when it is empty
+// SIZE must be a power of 2, the queue holds up to SIZE-1 items
+template <typename T, uint8_t SIZE>
+class SpscQueue {
+    static_assert(SIZE>=2 && (SIZE & (SIZE-1))==0, "SpscQueue SIZE must be a power of 2");
+
+    private:
+        T mItems[SIZE];
+        std::atomic<uint8_t> mHead{0}; // next item to pop, written only by the consumer
+        std::atomic<uint8_t> mTail{0}; // next free item, written only by the producer
+
+    public:
+        // producer side
+        // return value: true=item stored, false=queue full
+        bool Push(const T &item) {
+            uint8_t tail=mTail.load(std::memory_order_relaxed);
+            uint8_t next=(tail+1) & (SIZE-1);
+            if (next==mHead.load(std::memory_order_acquire))
+                return false; // queue full
+            mItems[tail]=item;
+            mTail.store(next, std::memory_order_release);
+            return true;
+        }
+
+        // consumer side
+        // return value: true=oldest item copied into item_out, false=queue empty
+        bool Pop(T *item_out) {
+            uint8_t head=mHead.load(std::memory_order_relaxed);
+            if (head==mTail.load(std::memory_order_acquire))
+                return false; // queue empty
+            *item_out=mItems[head];
+            mHead.store((head+1) & (SIZE-1), std::memory_order_release);
+            return true;
+        }
+
+        // consumer side
+        bool IsEmpty(void) {
+            return mHead.load(std::memory_order_relaxed)==mTail.load(std::memory_order_acquire);
+        }
+};
@@ -18,19 +18,24 @@
 #include "Transceiver.h"
 
 // 0=debug off, 1=output to serial, 2=output to serial and optionally bluetooth with dbtprintln()
-#define DEBUG_ON 1
+// 3=deferred output to serial, printing does not delay the datagrams (see rgDebug.h)
+#define DEBUG_ON 3
 // 0=trace off, 1=output to serial, 2=output to serial and optionally bluetooth with trbtprintln()
 #define TRACE_ON 0
+// 0=profiling off, 1=profiling sections enabled (see rgDebug.h)
+#define PROFILE_ON 0
 // the oscilloscope probe ; comment out this line if not used
 //#define SCOPE_GPIO 21 
 #include "rgDebug.h"
 
 // set CPU FREQ 40-240 MHZ and setRetries(2, 0) for 100 dg/s
 
-Transceiver::Transceiver() {
+Transceiver::Transceiver(uint8_t ce_gpio, uint8_t cs_gpio) {
 	dbprintf("using library %s %s\n", RNGLIB_NAME, RNGLIB_VERSION);
-	RF24 transceiver(SPI_CE_GPIO, SPI_CS_GPIO, SPI_SPEED);
+	RF24 transceiver(ce_gpio, cs_gpio, SPI_SPEED);
     Radio_obj=transceiver;
+	Msg_Datagram=&Msg_Buffers[0];
+	Ack_Datagram=&Ack_Buffers[0];
 }
 
 // Configure the radio device to transmit with given RF output power
@@ -88,6 +93,7 @@ bool Transceiver::Setup(bool is_tx, uint16_t tx_device_id, uint16_t rx_device_id
 
 	// Set the fixed frequency
     Radio_obj.setChannel(mono_channel);
+	Current_Channel=mono_channel;
 	MonoChannel=mono_channel; // used later by AssignChannels()
 
 	if (is_tx)
@@ -115,21 +121,27 @@ bool Transceiver::Setup(bool is_tx, uint16_t tx_device_id, uint16_t rx_device_id
 	}
 
 	if (is_tx)
-		memset(&Msg_Datagram, 0, sizeof(MsgDatagram)); // initialize the first MSG datagram
+		memset(Msg_Buffers, 0, sizeof(Msg_Buffers)); // initialize the first MSG datagram
 	else {
 		// initialize the calculation of the average delay between received datagrams
 		compute_avg_datagram_period(0);
 
 	    // initialize the first ACK datagram for pipe 1
 		// The next time a message is received on pipe 1, the data in Ack_Datagram will be sent back in the ACK payload
-		memset(&Ack_Datagram, 0, sizeof(AckDatagram));
-        Radio_obj.writeAckPayload(1, &Ack_Datagram, sizeof(AckDatagram));
+		memset(Ack_Buffers, 0, sizeof(Ack_Buffers));
+        Radio_obj.writeAckPayload(1, Ack_Datagram, sizeof(AckDatagram));
 	}
 
 #if DEBUG_ON
 	dbprintf("CPU %lu MHz, SPI %u kHz\n", getCpuFrequencyMhz(), SPI_SPEED/1000);
 	dbprintln("----------------------------------------");
+#if DEBUG_ON == 3
+	// printPrettyDetails() writes directly to Serial, it would bypass the deferred output
+	dbprintf("Channel %u, PA level %u, data rate %u, CRC %u\n", Radio_obj.getChannel(), (unsigned int)Radio_obj.getPALevel(),
+		(unsigned int)Radio_obj.getDataRate(), (unsigned int)Radio_obj.getCRCLength());
+#else
     Radio_obj.printPrettyDetails(); // debug : print human readable data
+#endif
 	dbprintln("----------------------------------------");
 #endif
 
@@ -137,7 +149,21 @@ bool Transceiver::Setup(bool is_tx, uint16_t tx_device_id, uint16_t rx_device_id
 	return retval;
 }
 
-// Transmit a datagram and acquire the ACK of the previous one from the reception pipe, if any
+// Tx: return the MSG datagram that will be transmitted by the next call to Send()
+// the user code fills its message in place, while the radio still owns the datagram it has just sent
+// this buffer is not cleared and still contains the datagram sent before the last one
+Transceiver::MsgDatagram *Transceiver::NextMsg(void) {
+	return Msg_Next;
+}
+
+// Rx: return the ACK datagram that will be stored in the ACK payload by the next call to Receive()
+// the user code fills its message in place, while the radio owns the ACK payload waiting in pipe 1
+// this buffer is not cleared and still contains the ACK datagram sent before the last one
+Transceiver::AckDatagram *Transceiver::NextAck(void) {
+	return Ack_Next;
+}
+
+// Transmit the datagram returned by NextMsg() and acquire the ACK of the previous one from the reception pipe, if any
 // MSG/ACKVALUES CPU Freq	  Datarate	Time(µs)
 //    14/14		    80			250K	4185
 //    14/14		   160			250K	3967
@@ -152,58 +178,88 @@ bool Transceiver::Setup(bool is_tx, uint16_t tx_device_id, uint16_t rx_device_id
 // Return value: 
 //  true=MSG datagram sent and ACK datagram of previous datagram received
 //  false=MSG datagram sent but was not acknowledged with an ACK packet
-bool Transceiver::Send(uint16_t msg_type, uint16_t *message) {
+bool Transceiver::Send(uint16_t msg_type) {
+	profileSection("Send");
 	bool retval=true;
-	static uint16_t Counter_int=0; // 0 - 65535
 	
 	writeScope(HIGH);
 	//micros_t start_timer = micros();
 
-	Msg_Datagram.number=Counter_int++;
-	Msg_Datagram.type=msg_type;
-	memcpy(Msg_Datagram.message, message, sizeof(Msg_Datagram.message));
+	Msg_Next->number=Dg_Counter++;
+	Msg_Next->type=msg_type;
 
 	// write() blocks until the message is successfully acknowledged by the receiver or the timeout/retransmit maxima are reached
 	uint8_t pipe; // pipe number that received the ACK datagram
-	Radio_obj.write(&Msg_Datagram, sizeof(Msg_Datagram));
+	Radio_obj.write(Msg_Next, sizeof(MsgDatagram));
+	// the datagram just sent becomes Msg_Datagram, and the other buffer is lent to the user code
+	MsgDatagram *sent_dg=Msg_Next;
+	Msg_Next=Msg_Datagram;
+	Msg_Datagram=sent_dg;
 	if (Radio_obj.available(&pipe))
-		Radio_obj.read(&Ack_Datagram, sizeof(Ack_Datagram));  // read incoming ACK datagram
+		Radio_obj.read(Ack_Datagram, sizeof(AckDatagram));  // read incoming ACK datagram
 	else
 		retval=false;  // ACK datagram not received
 
+	uint8_t arc=0;
+#if COM_ART_ATTEMPTS
+	arc=Radio_obj.getARC(); // costs an SPI transaction, only worth it when the retransmissions are enabled
+#endif
+	record_trace(Msg_Datagram->number, Msg_Datagram->type, retval ? TRF_TX|TRF_ACK : TRF_TX, arc);
+
 	//dbprintf("Send time=%lu\n", micros() - start_timer);
 
 	writeScope(LOW);
 	return retval;
 }
 
-// Acquire a message from the reception pipe and send the given ACK datagram
+// Acquire a message from the reception pipe and prepare the ACK datagram returned by NextAck()
 // return immediately if no message available in the reception pipe
+// if a diversity radio is attached, the first copy of each datagram received by either radio is returned
 // MSG/ACKVALUES CPU Freq	  Datarate	Time(µs)
 //    10/5		    80			250K	<1000	*** recommended values for testing ***
 // You can use an oscilloscope to observe these events (macro defined in rgDebug.h) - define SCOPE_GPIO if you need this
 // Return value: false=received nothing (no message available in the reception pipe), true=received a datagram
-bool Transceiver::Receive(uint16_t ack_type, uint16_t *ack_message) {
+bool Transceiver::Receive(uint16_t ack_type) {
 	//trprintf("*** %s %s() begin\n", __FILE_NAME__, __FUNCTION__);
 	bool retval=false;
 	if (Radio_obj.available()) {
+		profileSection("Receive"); // only the calls receiving a datagram are measured
 		writeScope(HIGH);
-		Radio_obj.read(&Msg_Datagram, sizeof(Msg_Datagram));  // read incoming message and send outgoing ACK datagram
+		uint16_t last_number=Msg_Datagram->number;
+		Radio_obj.read(Msg_Datagram, sizeof(MsgDatagram));  // read incoming message and send outgoing ACK datagram
 
 		// Prepare next outgoing ACK datagram and store it in pipe 1,
 		// it will be transmitted by next call to read()
 		// and the transmitter will receive it in its pipe 0
-		Ack_Datagram.number=Msg_Datagram.number;
-		Ack_Datagram.type=ack_type;
-		memcpy(Ack_Datagram.message, ack_message, sizeof(Ack_Datagram.message));
-		Radio_obj.writeAckPayload(1, &Ack_Datagram, sizeof(Ack_Datagram));
-
-		if (Avg_Datagram_Period==0)
-			compute_avg_datagram_period(Msg_Datagram.number);
-
-		retval=true;
+		Ack_Next->number=Msg_Datagram->number;
+		Ack_Next->type=ack_type;
+		Radio_obj.writeAckPayload(1, Ack_Next, sizeof(AckDatagram));
+		// the datagram stored in the ACK payload becomes Ack_Datagram, and the other buffer is lent to the user code
+		AckDatagram *pending_dg=Ack_Next;
+		Ack_Next=Ack_Datagram;
+		Ack_Datagram=pending_dg;
+
+		// ignore this datagram if the diversity radio has already delivered it
+		retval=!(Diversity_Delivered && Msg_Datagram->number==last_number);
+		Diversity_Delivered=false;
 		writeScope(LOW);
     }
+	if (Diversity_obj && Diversity_obj->Radio_obj.available()) {
+		MsgDatagram *datagram=Diversity_obj->Msg_Datagram; // shortcut
+		Diversity_obj->Radio_obj.read(datagram, sizeof(MsgDatagram));
+		// keep this copy only if it did not arrive first on our own radio
+		if (!retval && datagram->number!=Msg_Datagram->number) {
+			memcpy(Msg_Datagram, datagram, sizeof(MsgDatagram));
+			Diversity_Delivered=true;
+			Diversity_Count++;
+			retval=true;
+		}
+	}
+	if (retval) {
+		record_trace(Msg_Datagram->number, Msg_Datagram->type, Diversity_Delivered ? TRF_DIVERSITY : 0, 0);
+		if (Avg_Datagram_Period==0)
+			compute_avg_datagram_period(Msg_Datagram->number);
+	}
 	//trprintf("*** %s %s() returns %d\n", __FILE_NAME__, __FUNCTION__, retval);
 	return retval;
 }
@@ -213,61 +269,137 @@ bool Transceiver::Receive(uint16_t ack_type, uint16_t *ack_message) {
 // - initialize the calculation by calling this method with dg_number=0
 // Return value: the average period, or 0 if not yet available
 void Transceiver::compute_avg_datagram_period(uint16_t dg_number) {
-	static const uint8_t AVG_COUNT=32;
-	static micros_t Timer_start=0;
-	static uint8_t Count=0;
-	static uint16_t Last_dg_number=0;
-
 	// if Rx is started before Tx then the calculation may be erroneous
 	// because the timing of the 1st few datagrams sent by Tx seems inaccurate
-	// so we ignore them
-	static uint8_t Ignored_count=0;
-
+	// so we ignore them (see Avg_Ignored_count)
 	if (dg_number==0) {
 		// initialize the calculation
 		Avg_Datagram_Period=0;
-		Last_dg_number=dg_number;
-		Count=0;
-		Timer_start=0;
-		Ignored_count=10;
+		Avg_Last_dg_number=dg_number;
+		Avg_Count=0;
+		Avg_Timer_start=0;
+		Avg_Ignored_count=10;
 	}
 	else {
-		if (Ignored_count==0) {
-			if (Timer_start==0) {
+		if (Avg_Ignored_count==0) {
+			if (Avg_Timer_start==0) {
 				// start the timer and do not count the 1st datagram
-				Count=0;
-				Last_dg_number=dg_number;
-				Timer_start=micros();
+				Avg_Count=0;
+				Avg_Last_dg_number=dg_number;
+				Avg_Timer_start=micros();
 			}
 			else {
-				Count++;
-				//dbprintf("at %lu count %d dg %d\n", micros(), Count, dg_number);
-				if (dg_number==Last_dg_number+1) {
-					if (Count==AVG_COUNT)
-						Avg_Datagram_Period=(micros()-Timer_start)/AVG_COUNT;
+				Avg_Count++;
+				//dbprintf("at %lu count %d dg %d\n", micros(), Avg_Count, dg_number);
+				if (dg_number==Avg_Last_dg_number+1) {
+					if (Avg_Count==AVG_COUNT)
+						Avg_Datagram_Period=(micros()-Avg_Timer_start)/AVG_COUNT;
 					else
-						Last_dg_number=dg_number;
+						Avg_Last_dg_number=dg_number;
 				}
 				else {
 					// missed a datagram : restart avg computation
-					// dbprintf("dg missed after %d/%d\n", Count, AVG_COUNT);
-					Timer_start=0;
+					// dbprintf("dg missed after %d/%d\n", Avg_Count, AVG_COUNT);
+					Avg_Timer_start=0;
 				}
 			}
 
 		}
 		else
-			Ignored_count--;
+			Avg_Ignored_count--;
 	}
 }
 
-void Transceiver::PrintMsgDatagram(MsgDatagram datagram) {
+// Store a record of the datagram just sent or received in the trace ring, overwriting the oldest record
+// this takes well under 1 µs : no SPI transaction, no formatting
+void Transceiver::record_trace(uint16_t number, uint8_t type, uint8_t flags, uint8_t arc) {
+#if COM_TRACE_RECORDS
+	if (!Trace_Paused) {
+		TraceRecord *record=&Trace_Ring[Trace_Count & (COM_TRACE_RECORDS-1)];
+		record->time=micros();
+		record->number=number;
+		record->channel=Current_Channel;
+		record->type=type;
+		record->flags=flags;
+		record->arc=arc;
+		record->state=TraceState;
+		Trace_Count++;
+	}
+#endif
+}
+
+// Rx: record a slot where no datagram was received (timeout), number is the number of the missing datagram
+void Transceiver::TraceMissed(uint16_t number) {
+	record_trace(number, 0, TRF_MISSED, 0);
+}
+
+/* Write the trace ring to out in binary, oldest record first, tools/trace2csv.cpp decodes this dump
+   the dump takes about 270 ms at 115200 baud for 256 records : each call writes only the bytes that out accepts
+   without blocking (see Stream::availableForWrite()), so that the datagrams are still sent and received on time
+   call this method in each pass of the loop until it returns true, the recording is suspended until then
+   the debug output must not be written to out meanwhile : use DEBUG_ON 0 or 3, see dbpause() in rgDebug.h
+   dump format (little endian):
+	char[8]   "NRFTRACE"
+	uint8_t   TRACE_VERSION
+	uint8_t   sizeof(TraceRecord)
+	uint16_t  number of records that follow
+	uint32_t  number of records written since startup
+	TraceRecord records[]
+   Return value: true=the dump is complete
+*/
+bool Transceiver::DumpTrace(Stream &out) {
+#if COM_TRACE_RECORDS
+	if (!Trace_Paused) {
+		// start a dump
+		Trace_Paused=true;
+		uint16_t count=min(Trace_Count, (uint32_t)COM_TRACE_RECORDS);
+		memcpy(Dump_Header.magic, "NRFTRACE", sizeof(Dump_Header.magic));
+		Dump_Header.version=TRACE_VERSION;
+		Dump_Header.record_size=sizeof(TraceRecord);
+		Dump_Header.count=count;
+		Dump_Header.total=Trace_Count;
+		// the oldest record is at the index of the next record to write, unless the ring is not full yet
+		Dump_First=(Trace_Count-count) & (COM_TRACE_RECORDS-1);
+		Dump_Offset=0;
+	}
+	const uint32_t dump_size=sizeof(TraceHeader)+Dump_Header.count*sizeof(TraceRecord);
+	int room=out.availableForWrite();
+	while (room>0 && Dump_Offset<dump_size) {
+		const uint8_t *data;
+		uint32_t length;
+		if (Dump_Offset<sizeof(TraceHeader)) {
+			data=(const uint8_t *)&Dump_Header+Dump_Offset;
+			length=sizeof(TraceHeader)-Dump_Offset;
+		}
+		else {
+			// the records from Dump_First to the end of the ring, then from the beginning of the ring
+			uint32_t ring_offset=(Dump_First*sizeof(TraceRecord)+Dump_Offset-sizeof(TraceHeader)) % sizeof(Trace_Ring);
+			data=(const uint8_t *)Trace_Ring+ring_offset;
+			length=min((uint32_t)(sizeof(Trace_Ring)-ring_offset), dump_size-Dump_Offset);
+		}
+		length=out.write(data, min(length, (uint32_t)room));
+		if (length==0)
+			break;
+		Dump_Offset+=length;
+		room-=length;
+	}
+	if (Dump_Offset<dump_size)
+		return false;
+	Trace_Paused=false;
+	return true;
+#else
+	dbprintln("Trace disabled, see COM_TRACE_RECORDS in Common.h");
+	return true;
+#endif
+}
+
+void Transceiver::PrintMsgDatagram(const MsgDatagram &datagram) {
 	dbprintf("(ch 0x%02x) %04x T%x ", Radio_obj.getChannel(), datagram.number, datagram.type);
 	for (uint8_t idx=0; idx<MSGVALUES; idx++)
 		dbprintf("0x%04x ", datagram.message[idx]);
 }
 
-void Transceiver::PrintAckDatagram(AckDatagram datagram) {
+void Transceiver::PrintAckDatagram(const AckDatagram &datagram) {
 	dbprintf("(ch 0x%02x) %04x T%x ", Radio_obj.getChannel(), datagram.number, datagram.type);
 	for (uint8_t idx=0; idx<ACKVALUES; idx++)
 		dbprintf("0x%04x ", datagram.message[idx]);
@@ -313,8 +445,11 @@ void Transceiver::arrange_values(
 // Assign random values to the array of radio channels
 // using the key previously set by SetSessionKey()
 void Transceiver::AssignChannels(void) {
+	profileSection("AssignChannels");
 	//trprintf("AssignChannels(%d)\n", GetSessionKey());
 	arrange_values(SessionKey, DEF_MAXCHAN, DEF_MONOCHAN, MonoChannel, sizeof(RF24Channels), RF24Channels);
+	if (Diversity_obj)
+		Diversity_obj->AssignChannels();
 	/*
 	** CAUTION: printing this array takes too long and causes timing issues processing the first datagrams
 	for (uint8_t idx=0; idx<sizeof(RF24Channels); idx++) {
@@ -333,11 +468,16 @@ uint8_t Transceiver::GetChannel(void) {
 
 // Use the radio channel corresponding to given datagram number
 void Transceiver::SetChannel(uint16_t dg_number) {
-	Radio_obj.setChannel(RF24Channels[dg_number % sizeof(RF24Channels)]);
+	Current_Channel=RF24Channels[dg_number % sizeof(RF24Channels)];
+	Radio_obj.setChannel(Current_Channel);
+	if (Diversity_obj)
+		Diversity_obj->SetChannel(dg_number);
 }
 
 void Transceiver::SetPaLevel(int value) {
     Radio_obj.setPALevel(value);
+	if (Diversity_obj)
+		Diversity_obj->SetPaLevel(value);
 }
 
 uint16_t Transceiver::GetSessionKey(void) {
@@ -345,6 +485,41 @@ uint16_t Transceiver::GetSessionKey(void) {
 }
 void Transceiver::SetSessionKey(uint16_t key) {
 	SessionKey=key;
+	if (Diversity_obj)
+		Diversity_obj->SetSessionKey(key);
+}
+
+// Rx low power : stop listening and keep the radio in standby mode until Listen() is called
+void Transceiver::Standby(void) {
+	Radio_obj.stopListening(); // this also discards the ACK payload waiting in pipe 1
+	if (Diversity_obj)
+		Diversity_obj->Standby();
+}
+
+// Rx low power : resume listening after Standby(), the radio needs 130 µs to settle in RX mode
+void Transceiver::Listen(void) {
+	Radio_obj.startListening();
+	Radio_obj.writeAckPayload(1, Ack_Datagram, sizeof(AckDatagram)); // restore the ACK payload discarded by Standby()
+	if (Diversity_obj)
+		Diversity_obj->Listen(); // writeAckPayload() does nothing on the diversity radio
+}
+
+// Rx antenna diversity : use the given second radio as a listen-only copy of this one
+// the secondary radio must have been configured by Setup() with the same parameters as this one
+// it follows our hop sequence and Receive() returns the first copy of each datagram received by either radio
+// only our own radio acknowledges the datagrams, the secondary radio never transmits
+// so that both ACKs do not collide on the air ; as a result the auto-acknowledgement and the dynamic
+// payloads are disabled on the secondary radio, which receives the MSG datagrams with a static payload size
+void Transceiver::AttachDiversity(Transceiver *secondary) {
+	secondary->Radio_obj.setAutoAck(1, false);
+	secondary->Radio_obj.disableDynamicPayloads(); // this also disables the ACK payloads
+	secondary->Radio_obj.setPayloadSize(sizeof(MsgDatagram));
+	secondary->Radio_obj.flush_tx(); // discard the ACK payload written by Setup()
+	secondary->SetSessionKey(SessionKey);
+	secondary->Current_Channel=Current_Channel;
+	secondary->Radio_obj.setChannel(Current_Channel);
+	Diversity_obj=secondary;
+	dbprintln("Diversity radio attached");
 }
 
 // Extract the 1st "count" bytes (max 8) of "number" into array "bytes"
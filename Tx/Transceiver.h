@@ -17,6 +17,7 @@
 #include <SPI.h>
 #include <RF24.h>
 #include "Common.h"
+#include "Gpio.h"
 #include "rgRng.h"
 
 typedef unsigned long micros_t; // custom name for data type suitable for times in microseconds
@@ -56,9 +57,9 @@ class Transceiver {
             uint16_t type;  // see above
             uint16_t message[MSGVALUES];
         };
-        MsgDatagram Msg_Datagram; // sent from Tx -> Rx
+        MsgDatagram *Msg_Datagram; // sent from Tx -> Rx : the last datagram sent by Tx, the last datagram received by Rx
 
-        /* ACKVALUES min=1, max=14
+        /* ACKVALUES min=2, max=14 (2 values are used by service datagrams sent by Rx while running in MONOFREQ mode)
             Rx_state = SYNCHRONIZING :  dg_number T1 0x0000 0x0000
             Rx_state = MONOFREQ :       dg_number T5 multifreq_number session_key
             Rx_state = MULTIFREQ :      dg_number T2 error_counter voltage
@@ -69,22 +70,52 @@ class Transceiver {
             uint16_t type;  // see above
             uint16_t message[ACKVALUES];
         };
-        AckDatagram Ack_Datagram; // sent from Rx -> Tx
+        AckDatagram *Ack_Datagram; // sent from Rx -> Tx : the last datagram received by Tx, the datagram waiting in the ACK payload of Rx
 
         micros_t Avg_Datagram_Period=0; // microsec, computed by compute_avg_datagram_period()
 
-        Transceiver();
+        // number of datagrams missed by this radio but received by the diversity radio, see AttachDiversity()
+        uint32_t Diversity_Count=0;
+
+        // Radio event trace : Send() and Receive() record each datagram sent by Tx or received by Rx,
+        // and Rx records each slot missed with TraceMissed(), see DumpTrace()
+        struct TraceRecord {
+            uint32_t time;   // micros() when the datagram was sent or received
+            uint16_t number; // datagram number
+            uint8_t channel; // radio channel
+            uint8_t type;    // MSG datagram type
+            uint8_t flags;   // combination of the TRF_ bits
+            uint8_t arc;     // Tx: number of auto retransmissions (0 if COM_ART_ATTEMPTS=0)
+            uint8_t state;   // value of TraceState
+            uint8_t reserved;
+        };
+        static const uint8_t TRF_TX=0x1;        // recorded by Send(), else recorded by Receive()
+        static const uint8_t TRF_ACK=0x2;       // Tx: ACK datagram received
+        static const uint8_t TRF_DIVERSITY=0x4; // Rx: datagram delivered by the diversity radio
+        static const uint8_t TRF_MISSED=0x8;    // Rx: no datagram received in the slot (timeout), see TraceMissed()
+        static const uint8_t TRACE_VERSION=2;   // version of the dump format
+        uint8_t TraceState=0; // stored in each trace record, the application sets it to Tx_state or Rx_state
+
+        // each instance drives its own nRF24 module, wired to the given CE and CS gpios
+        Transceiver(uint8_t ce_gpio=SPI_CE_GPIO, uint8_t cs_gpio=SPI_CS_GPIO);
         bool Setup(bool is_tx, uint16_t tx_device_id, uint16_t rx_device_id, uint16_t mono_channel, uint16_t pa_level);
-        bool Send(uint16_t msg_type, uint16_t *message);
-        bool Receive(uint16_t ack_type, uint16_t *ack_message);
-        void PrintMsgDatagram(MsgDatagram datagram);
-        void PrintAckDatagram(AckDatagram datagram);
+        MsgDatagram *NextMsg(void);
+        AckDatagram *NextAck(void);
+        bool Send(uint16_t msg_type);
+        bool Receive(uint16_t ack_type);
+        void PrintMsgDatagram(const MsgDatagram &datagram);
+        void PrintAckDatagram(const AckDatagram &datagram);
         void AssignChannels(void);
         uint8_t GetChannel(void);
         void SetChannel(uint16_t dg_number);
         void SetPaLevel(int value);
         uint16_t GetSessionKey(void);
         void SetSessionKey(uint16_t key);
+        void AttachDiversity(Transceiver *secondary);
+        void Standby(void);
+        void Listen(void);
+        void TraceMissed(uint16_t number);
+        bool DumpTrace(Stream &out);
         
     private:
         
@@ -106,11 +137,51 @@ class Transceiver {
         // MonoChannel and DEF_MONOCHAN are not in the array
         uint8_t RF24Channels[DEF_MAXCHAN-1];
         uint16_t SessionKey=0; // random seed used to generate the RF24Channels[] array
+        uint8_t Current_Channel=0; // copy of the radio channel, reading it from the nRF24 would take an SPI transaction
 
         rgRng Random_obj;
 
+        // Double buffering of the outgoing datagrams, see NextMsg() and NextAck()
+        // the user code fills *Msg_Next (Tx) or *Ack_Next (Rx) in place, while the radio owns *Msg_Datagram or *Ack_Datagram
+        MsgDatagram Msg_Buffers[2];
+        AckDatagram Ack_Buffers[2];
+        MsgDatagram *Msg_Next=&Msg_Buffers[1];
+        AckDatagram *Ack_Next=&Ack_Buffers[1];
+
+        // datagram counter used by Send()
+        uint16_t Dg_Counter=0; // 0 - 65535
+
+        // state of compute_avg_datagram_period()
+        static const uint8_t AVG_COUNT=32;
+        micros_t Avg_Timer_start=0;
+        uint8_t Avg_Count=0;
+        uint16_t Avg_Last_dg_number=0;
+        uint8_t Avg_Ignored_count=0;
+
+        // Rx antenna diversity : this second radio listens to the same hop sequence, see AttachDiversity()
+        Transceiver *Diversity_obj=NULL;
+        bool Diversity_Delivered=false; // Msg_Datagram was delivered by Diversity_obj, its copy may still arrive on this radio
+
+#if COM_TRACE_RECORDS
+        static_assert((COM_TRACE_RECORDS & (COM_TRACE_RECORDS-1))==0, "COM_TRACE_RECORDS must be a power of 2");
+        TraceRecord Trace_Ring[COM_TRACE_RECORDS];
+        uint32_t Trace_Count=0;          // number of records written since startup
+        volatile bool Trace_Paused=false; // set by DumpTrace() while a dump is in progress
+        struct __attribute__((packed)) TraceHeader {
+            char magic[8];
+            uint8_t version;
+            uint8_t record_size;
+            uint16_t count;
+            uint32_t total;
+        };
+        TraceHeader Dump_Header;  // header of the dump in progress
+        uint16_t Dump_First=0;    // index of the oldest record in Trace_Ring
+        uint32_t Dump_Offset=0;   // number of bytes of the dump already written
+#endif
+
         void get_bytes(uint8_t bytes[], uint64_t number, uint8_t count);
         void compute_avg_datagram_period(uint16_t dg_number);
+        void record_trace(uint16_t number, uint8_t type, uint8_t flags, uint8_t arc);
         void arrange_values(const unsigned int key, const uint8_t max_value, const uint8_t ignored_value1, const uint8_t ignored_value2, const uint8_t sizeof_values_out, uint8_t *values_out);
 
 };
@@ -43,15 +43,22 @@
 #include <rgBtn.h>
 #include <rgCsv.h>
 #include "Common.h"
+#include "AdcSampler.h"
 #include "Gpio.h"
+#include "Led.h"
+#include "Mixer.h"
 #include "Settings.h"
+#include "SpscQueue.h"
 #include "Transceiver.h"
 #include "User.h"
 
 // 0=debug off, 1=output to serial, 2=output to serial and optionally bluetooth with dbtprintln()
-#define DEBUG_ON 1
+// 3=deferred output to serial, printing does not delay the datagrams (see rgDebug.h)
+#define DEBUG_ON 3
 // 0=trace off, 1=output to serial, 2=output to serial and optionally bluetooth with trbtprintln()
 #define TRACE_ON 0
+// 0=profiling off, 1=profiling sections enabled (see rgDebug.h)
+#define PROFILE_ON 0
 #include <rgDebug.h>
 
 Settings Settings_obj;
@@ -69,14 +76,29 @@ Transceiver Transceiver_obj;
 // Pairing may be started by pressing the Pairing button while in MONOFREQ
 // User data is transmitted while MULTIFREQ
 enum TxStates {MONOFREQ, MULTIFREQ};
-TxStates Tx_state=MONOFREQ;
+volatile TxStates Tx_state=MONOFREQ;
 
 bool RunLedEnabled=(RUNLED_GPIO!=0); // true by default, false when the Pairing button is pressed
+Led RunLed_obj;
+Led ErrLed_obj;
+
+// ADC inputs configured in UserSetup(), their newest values are latched before each call to UserLoopMsg()
+AdcSampler AdcSampler_obj;
+
+// channel mixer used by UserLoopMsg(), its curves are precomputed by Mixer::Load() at boot
+Mixer Mixer_obj;
+
+// The buttons are handled by interrupts, check_buttons() reads their events in the user context
+rgBtnManager Buttons_obj;
+int Pairing_btn=-1;
+const unsigned long PAIRING_HOLD=1500;   // ms, hold the Pairing button this long to start pairing while in MONOFREQ
+volatile bool PairingRequested=false;    // set by check_buttons(), read by send()
+unsigned long Pairing_blink_until=0;     // ms, the Run Led blinks rapidly until then to tell the user to release the button
 
-uint16_t Msg_message[Transceiver::MSGVALUES];
 uint16_t Msg_type=Transceiver::DGT_SERVICE;
 
 uint16_t ErrorCounter=0;  // number of transmission errors per second, updated once/second
+uint8_t IdlePercent=0;    // percentage of time spent waiting for the next slot, updated once/second
 
 // DGPERIOD is the delay between 2 datagrams, in microseconds
 // Acceptable CPU speed for DGPERIOD=10000 : 80-240 MHz on Tx and/or Rx
@@ -85,6 +107,16 @@ const micros_t DGPERIOD=1000000/COM_TRANS_DGS; // microseconds, must be multiple
 
 bool PairingInProgress=false;
 
+#if COM_LOW_POWER
+#if COM_DUAL_CORE
+#error "COM_LOW_POWER requires COM_DUAL_CORE=0"
+#endif
+// The hardware timer stops while the CPU is in light sleep, so the slots are scheduled with micros() instead
+// micros() keeps counting in light sleep
+micros_t Next_slot_us=0; // start time of the next slot
+const micros_t LIGHTSLEEP_MIN_US=2000;    // do not sleep if the next slot begins sooner than this
+const micros_t LIGHTSLEEP_WAKEUP_US=1000; // wake up this early, then wait for the exact start of the slot
+#else
 // Autorepeat timer used to transmit datagrams periodically
 // see https://docs.espressif.com/projects/arduino-esp32/en/latest/api/timer.html
 hw_timer_t * Timer_obj = NULL;
@@ -93,17 +125,35 @@ volatile SemaphoreHandle_t Semaphore_obj;
 void ARDUINO_ISR_ATTR onTimer(){
     xSemaphoreGiveFromISR(Semaphore_obj, NULL);
 }
+#endif
+
+#if COM_DUAL_CORE
+// Dual-core pipeline : radio_task() runs send() on core 0 and loop() runs the user code on core 1
+// the user task builds the next MSG datagram after each slot, the radio task reports each slot with an AckEvent
+struct AckEvent {
+    bool sent;      // false=nothing transmitted in this slot because the user code is in "Command" mode
+    bool result;    // value returned by send()
+    Transceiver::AckDatagram datagram;
+};
+SpscQueue<Transceiver::MsgDatagram, 4> MsgQueue_obj; // user task -> radio task
+SpscQueue<AckEvent, 8> AckQueue_obj;                 // radio task -> user task
+TaskHandle_t UserTask_obj=NULL;
+volatile bool UserCommandMode=false; // true while UserLoopBegin() returns non-zero
+#endif
 
 void setup() {
     Serial.begin(115200);
     while (!Serial) ; // wait for serial port to connect
+    setupLog(); // start the task printing the deferred debug output
 #if DEBUG_ON
 	dbprint('\n'); for (uint8_t idx = 0; idx<6; idx++) { dbprint((char)('A'+idx)); delay(500); }
 #endif
     dbprintf("\n\n*** %s %s() : %s %s\n", __FILE_NAME__, __FUNCTION__, APP_NAME, APP_VERSION);
     dbprintf("using library %s %s\n", BTNLIB_NAME, BTNLIB_VERSION);
     dbprintf("using library %s %s\n", CSVLIB_NAME, CSVLIB_VERSION);
-    pinMode(PAIRING_GPIO, INPUT_PULLUP);
+    Pairing_btn=Buttons_obj.Add(PAIRING_GPIO, 3000); // see BUTTON_HOLD below
+    if (!Buttons_obj.Begin())
+        EndProgram(true, "Setup: button initialization error");
     if (RUNLED_GPIO)
         pinMode(RUNLED_GPIO, OUTPUT);
     if (ERRLED_GPIO)
@@ -117,8 +167,9 @@ void setup() {
         EndProgram(true, "Setup: file system formatting error");
 
     // Hold the Pairing button during boot to delete the settings file
-    const int BUTTON_HOLD=3000; // ms, hold the button long enough to create a new file with default values
-    BtnStates btn_state=ReadBtnBlock(PAIRING_GPIO, RUNLED_GPIO, BUTTON_HOLD); // ms
+    // BUTTON_HOLD=3000 ms given to Buttons_obj.Add() : hold the button long enough to create a new file with default values
+    BtnStates btn_state=Buttons_obj.WaitRelease(Pairing_btn, RUNLED_GPIO);
+    Buttons_obj.SetLongPress(Pairing_btn, PAIRING_HOLD);
     if (btn_state==BTN_REACHED_DURATION) {
         if (LittleFS.exists(Settings_obj.PARFILE)) {
             if (LittleFS.remove(Settings_obj.PARFILE))
@@ -130,11 +181,20 @@ void setup() {
             dbprintf("Setup: settings file \"%s\" not found\n", Settings_obj.PARFILE);
     }
 
+    // from now on the leds are driven by their timers, see refresh_leds()
+    if (!RunLed_obj.Begin(RUNLED_GPIO) || !ErrLed_obj.Begin(ERRLED_GPIO))
+        EndProgram(true, "Setup: led initialization error");
+
     // Open the settings file, create it if it does not exist
     // default values are provided only for creating the settings file
     if (Settings_obj.Init(Transceiver::DEF_TXID, Transceiver::DEF_RXID, Transceiver::DEF_MONOCHAN, Transceiver::DEF_PALEVEL))
         EndProgram(true, "Setup: Settings file error");
 
+    // read the mixer file, the default mixer is used if it does not exist
+    int mixer_result=Mixer_obj.Load();
+    if (mixer_result<0 && mixer_result!=-2)
+        dbprintf("Setup: mixer file error %d\n", mixer_result);
+
     // read the transceiver settings from the settings file
     int tx_device_id=Settings_obj.GetTxDeviceId();
     int rx_device_id=Settings_obj.GetRxDeviceId();
@@ -156,17 +216,17 @@ void setup() {
     if (tx_device_id==(int)Transceiver::DEF_TXID) {
         // if this is the first boot ever, assign random values to settings "TXID", "RXID" and "MONOCHAN"
         dbprintln("Settings initialization");
-        tx_device_id=GetRandomInt16() & 0x7fff; // keep only 15 bits to ensure it is a positive when stored in a int16_t
+        tx_device_id=GetRandomInt16(); // the settings file stores 32-bit integers
         rx_device_id=tx_device_id;
         while(rx_device_id==tx_device_id)
-            rx_device_id=GetRandomInt16() & 0x7fff;
+            rx_device_id=GetRandomInt16();
         mono_channel=Transceiver::DEF_MONOCHAN;
         while (mono_channel==Transceiver::DEF_MONOCHAN)
             mono_channel=GetRandomInt16()%(Transceiver::DEF_MAXCHAN+1);
         Settings_obj.SetTxDeviceId(tx_device_id);
         Settings_obj.SetRxDeviceId(rx_device_id);
         Settings_obj.SetMonoChannel(mono_channel);
-        if (Settings_obj.Save()<0)
+        if (profileCall("Settings::Save", Settings_obj.Save())<0)
             EndProgram(true, "Settings write error"); // halt command, could not save settings
     }
     
@@ -178,9 +238,9 @@ void setup() {
     //dbprintf("setup() SessionKey 0x%04x\n", Transceiver_obj.GetSessionKey());
     Transceiver_obj.AssignChannels();
 
-    // clear data in the MSG message buffer : datagram number 0 will contain only zeros
-    memset(Msg_message, 0, sizeof(Msg_message));
-
+#if COM_LOW_POWER
+    Next_slot_us=micros()+DGPERIOD;
+#else
     // this semaphore tells when the timer has fired
     // we use it to make the onTimer() ISR return as fast as possible
     Semaphore_obj = xSemaphoreCreateBinary();
@@ -192,25 +252,38 @@ void setup() {
     // Repeat the alarm (third parameter) with unlimited count = 0 (fourth parameter)
     // onTimer() will be called when the counter of Timer_obj reaches this value, and the counter will be reset to 0
     timerAlarm(Timer_obj, DGPERIOD/100, true, 0);
+#endif
 
     // Run user setup code
     UserSetup(rx_device_id);
 
+#if COM_DUAL_CORE
+    // from now on loop() runs only the user code, and the radio timing runs in radio_task() on core 0
+    UserTask_obj=xTaskGetCurrentTaskHandle();
+    xTaskCreatePinnedToCore(radio_task, "Radio", 4096, NULL, configMAX_PRIORITIES-1, NULL, 0);
+#endif
+
     trprintf("*** %s %s() returns after %lu ms\n", __FILE_NAME__, __FUNCTION__, millis());
 }
 
 void loop() {
+    check_serial_command();
+    check_buttons();
+    profileReport(10000); // print the profiling summary every 10 seconds if PROFILE_ON
+#if COM_DUAL_CORE
+    user_loop();
+#else
     bool result=true;
-    if (xSemaphoreTake(Semaphore_obj, 0) == pdTRUE) {
+    if (wait_next_slot()) {
         // micros_t start_timer = micros();
         if (UserLoopBegin())
             return; // do not transmit anything while in "Command" mode
         
         if (Tx_state==MULTIFREQ) {
-            // fill up the message datagram with user's data
+            // fill up the next message datagram in place with user's data
             Msg_type=Transceiver::DGT_USER;
-            memset(Msg_message, 0, sizeof(Msg_message));
-            UserLoopMsg(Msg_message);
+            AdcSampler_obj.Latch(); // at the beginning of the slot
+            profileCall("UserLoopMsg", UserLoopMsg(Transceiver_obj.NextMsg()->message));
         }
         else {
             // datagrams transmitted before reaching the MULTIFREQ state are service datagrams,
@@ -225,39 +298,194 @@ void loop() {
 
 #ifdef DEBUG_PRINT_MSG_DATAGRAMS
         dbprint("Msg: ");
-        Transceiver_obj.PrintMsgDatagram(Transceiver_obj.Msg_Datagram);
+        Transceiver_obj.PrintMsgDatagram(*Transceiver_obj.Msg_Datagram);
         dbprint('\n');
 #endif
-        if (result) {
-            if (Transceiver_obj.Ack_Datagram.type & Transceiver::DGT_USER) {
+        process_ack(result, Transceiver_obj.Ack_Datagram);
+        //dbprintf("Send time=%lu\n", micros() - start_timer);
+    }
+    refresh_leds(result);
+#endif
+}
+
+// Block until the beginning of the next slot, and measure the time spent waiting
+// with COM_LOW_POWER the CPU enters light sleep while waiting, and the nRF24 stays in standby mode
+// (Send() leaves it in standby after receiving the ACK datagram, powering it down would take too long to restart)
+// Return value: true=the next slot begins now
+bool wait_next_slot(void) {
+    static micros_t Idle_us=0;       // time spent waiting since Stat_time
+    static unsigned long Stat_time=0; // ms, to compute IdlePercent every second
+    micros_t start_time=micros();
+#if COM_LOW_POWER
+    // skip the slots missed while we were busy
+    while ((long)(start_time-Next_slot_us)>=0)
+        Next_slot_us+=DGPERIOD;
+    if (Next_slot_us-start_time>=LIGHTSLEEP_MIN_US) {
+        Serial.flush(); // the UART stops in light sleep
+        long sleep_us=(long)(Next_slot_us-micros())-LIGHTSLEEP_WAKEUP_US;
+        if (sleep_us>0) {
+            esp_sleep_enable_timer_wakeup(sleep_us);
+            esp_light_sleep_start();
+        }
+    }
+    while ((long)(Next_slot_us-micros())>0)
+        ; // wait for the exact start of the slot
+    Next_slot_us+=DGPERIOD;
+    bool retval=true;
+#else
+    bool retval=(xSemaphoreTake(Semaphore_obj, portMAX_DELAY)==pdTRUE);
+#endif
+    Idle_us+=micros()-start_time;
+
+    unsigned long time_now_ms=millis();
+    if (time_now_ms>=Stat_time+1000) {
+        IdlePercent=Idle_us/((time_now_ms-Stat_time)*10); // update the global IdlePercent once/second
+        Idle_us=0;
+        Stat_time=time_now_ms;
+    }
+    return retval;
+}
+
+// Pass the ACK datagram of the previous MSG datagram to the user code
+void process_ack(bool result, Transceiver::AckDatagram *ack_dg) {
+    if (result) {
+        if (ack_dg->type & Transceiver::DGT_USER) {
 #ifdef DEBUG_PRINT_ACK_DATAGRAMS
-                dbprint("Ack: ");
-                Transceiver_obj.PrintAckDatagram(Transceiver_obj.Ack_Datagram);
-                dbprint('\n');
+            dbprint("Ack: ");
+            Transceiver_obj.PrintAckDatagram(*ack_dg);
+            dbprint('\n');
 #endif
-                UserLoopAck(Transceiver_obj.Ack_Datagram.message);
-            }
+            UserLoopAck(ack_dg->message);
         }
+    }
 #ifdef DEBUG_PRINT_ACK_DATAGRAMS
-        else
-            dbprintln("no ACK");
+    else
+        dbprintln("no ACK");
 #endif
-        //dbprintf("Send time=%lu\n", micros() - start_timer);
+}
+
+// Serial commands, sent from the serial monitor:
+//  'T' dump the radio event trace in binary, see Transceiver::DumpTrace()
+void check_serial_command(void) {
+    // the dump is written in several passes of loop() without blocking, see Transceiver::DumpTrace()
+    static bool Dump_requested=false;
+    static bool Dumping=false;
+    if (!Dump_requested && Serial.available() && Serial.read()=='T')
+        Dump_requested=true;
+    // do not mix the debug output with the binary dump : wait until the drain task has written its records,
+    // then keep it from writing the records queued meanwhile by the other tasks
+    if (Dump_requested && !Dumping)
+        Dumping=dbpause();
+    if (Dumping && Transceiver_obj.DumpTrace(Serial)) {
+        Dump_requested=Dumping=false;
+        dbresume();
     }
-        
+}
 
+// Process the events of the Pairing button while in MONOFREQ
+// pressing the Pairing button while in MULTIFREQ or while pairing has no effect
+// the transceiver is reconfigured by send() in the radio context, see PairingRequested
+void check_buttons(void) {
+    BtnEvent event;
+    while (Buttons_obj.GetEvent(&event)) {
+        if (event.button!=Pairing_btn)
+            continue;
+        if (event.type!=BTN_RELEASE && (Tx_state!=MONOFREQ || PairingRequested))
+            continue; // the release is always processed to restore the Run Led
+        switch (event.type) {
+            case BTN_PRESS:
+                RunLedEnabled=false; // Led stays on while the button is pressed
+                RunLed_obj.On();
+                break;
+            case BTN_LONG_PRESS:
+                // blink led for 3 seconds to tell user that he can release the button
+                Pairing_blink_until=millis()+3000;
+                PairingRequested=true;
+                break;
+            case BTN_RELEASE:
+                RunLed_obj.Off();
+                RunLedEnabled=(RUNLED_GPIO!=0);
+                break;
+        }
+    }
+}
+
+// the leds are driven by their timers : these calls only change the pattern of a led when the state changes
+void refresh_leds(bool result) {
+    if ((long)(Pairing_blink_until-millis())>0) {
+        RunLed_obj.Blink(100, 50);
+        return;
+    }
     if (Tx_state==MULTIFREQ) {
         if (RunLedEnabled)
-            BlinkLed(RUNLED_GPIO, 2000, 20, false); // short flash once / every 2 seconds (0.5 Hz)
+            RunLed_obj.Blink(2000, 20); // short flash once / every 2 seconds (0.5 Hz)
         if (!result)
-            FlashLed(ERRLED_GPIO, 20); // ACK datagram not received : turn on ERRLED_GPIO
-        else
-            FlashLed(ERRLED_GPIO); // refresh ERRLED_GPIO 
+            ErrLed_obj.Flash(20); // ACK datagram not received : turn on ERRLED_GPIO
     }
     else if (RunLedEnabled)
-        BlinkLed(RUNLED_GPIO, 500, 200, false); // longer flash twice / second (2 Hz)
+        RunLed_obj.Blink(500, 200); // longer flash twice / second (2 Hz)
 }
 
+#if COM_DUAL_CORE
+// Radio task pinned to core 0 : transmit a datagram each time the timer fires
+// nothing else runs here, so the user code cannot delay the transmission
+void radio_task(void *parameters) {
+    while (1) {
+        wait_next_slot();
+        AckEvent event;
+        event.sent=!UserCommandMode; // do not transmit anything while in "Command" mode
+        event.result=false;
+        if (event.sent) {
+            if (Tx_state==MULTIFREQ) {
+                // transmit the newest datagram built by the user task, or repeat the previous one
+                bool fresh_frame=false;
+                while (MsgQueue_obj.Pop(Transceiver_obj.NextMsg()))
+                    fresh_frame=true;
+                if (!fresh_frame)
+                    memcpy(Transceiver_obj.NextMsg()->message, Transceiver_obj.Msg_Datagram->message, sizeof(Transceiver_obj.Msg_Datagram->message));
+                Msg_type=Transceiver::DGT_USER;
+            }
+            else
+                Msg_type=Transceiver::DGT_SERVICE;
+            event.result=send();
+            event.datagram=*Transceiver_obj.Ack_Datagram;
+        }
+        AckQueue_obj.Push(event); // this event is lost if the user task is more than 7 slots late
+        xTaskNotifyGive(UserTask_obj);
+    }
+}
+
+// User task running on core 1 in loop() : process the ACK datagrams and build the next MSG datagram
+void user_loop(void) {
+    static bool Last_result=true;
+    bool slot_complete=false;
+    AckEvent event;
+
+    // wait for the radio task to complete a slot, but refresh the Leds at least every DGPERIOD
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DGPERIOD/1000));
+    while (AckQueue_obj.Pop(&event)) {
+        if (event.sent) {
+            process_ack(event.result, &event.datagram);
+            Last_result=event.result;
+        }
+        slot_complete=true;
+    }
+    if (slot_complete) {
+        UserCommandMode=(UserLoopBegin()!=0);
+        if (!UserCommandMode && Tx_state==MULTIFREQ) {
+            // fill up the next message datagram with user's data
+            Transceiver::MsgDatagram datagram;
+            memset(datagram.message, 0, sizeof(datagram.message));
+            AdcSampler_obj.Latch(); // just after the slot, before the datagram of the next slot is built
+            profileCall("UserLoopMsg", UserLoopMsg(datagram.message));
+            MsgQueue_obj.Push(datagram);
+        }
+    }
+    refresh_leds(Last_result);
+    Last_result=true; // flash ERRLED_GPIO only once per missing ACK datagram
+}
+#endif
+
 // Return value: 
 //  true=MSG datagram sent and ACK datagram of previous datagram received
 //  false=MSG datagram sent and ACK datagram of previous datagram not received
@@ -273,7 +501,7 @@ bool send(void) {
 
     if (time_now_ms >= Sig_timer+1000) {
         dbprintf("(ch 0x%02x) tx_device_id=0x%06x rx_device_id=0x%06x dg_number=%u no signal\n",
-            Transceiver_obj.GetChannel(), Settings_obj.GetTxDeviceId(), Settings_obj.GetRxDeviceId(), Transceiver_obj.Msg_Datagram.number);
+            Transceiver_obj.GetChannel(), Settings_obj.GetTxDeviceId(), Settings_obj.GetRxDeviceId(), Transceiver_obj.Msg_Datagram->number);
         Sig_timer=time_now_ms;
     }
 
@@ -286,10 +514,10 @@ bool send(void) {
         }
     }
 
-    retval=Transceiver_obj.Send(Msg_type, Msg_message);
+    retval=Transceiver_obj.Send(Msg_type);
     if (retval) {
         Sig_timer=time_now_ms; // to print "no signal" warning every second
-        Transceiver::AckDatagram *ack_dg=&Transceiver_obj.Ack_Datagram; // shortcut
+        Transceiver::AckDatagram *ack_dg=Transceiver_obj.Ack_Datagram; // shortcut
         if (ack_dg->type & Transceiver::DGT_SERVICE) {
             if ((ack_dg->type & Transceiver::DGT_SYNCHRONIZED) && ack_dg->message[1]==Transceiver_obj.GetSessionKey() && Multifreq_number==0) {
                 // we received the first datagram telling us Rx is synchronized
@@ -304,14 +532,19 @@ bool send(void) {
         }
     }
     if (Tx_state==MONOFREQ) {
-        if (Multifreq_number && Transceiver_obj.Msg_Datagram.number==Multifreq_number) {
+        if (Multifreq_number && Transceiver_obj.Msg_Datagram->number==Multifreq_number) {
             // we have sent the last datagram of the synchronized sequence
             if (Pairing_complete) {
                 dbprintln("Reboot after pairing");
+                dbflush();
                 EndProgram(true); // reset command
             }
             //switch to MULTIFREQ
+            // clear the service data from both datagram buffers, the user code may not overwrite all the values
+            memset(Transceiver_obj.NextMsg()->message, 0, sizeof(Transceiver_obj.NextMsg()->message));
+            memset(Transceiver_obj.Msg_Datagram->message, 0, sizeof(Transceiver_obj.Msg_Datagram->message));
             Tx_state=MULTIFREQ;
+            Transceiver_obj.TraceState=Tx_state;
             dbprintf("MULTIFREQ after %lu ms, period=%lu µs (%u dg/s)\n", millis(), DGPERIOD, (unsigned int)(1000000/DGPERIOD));
         }
         else {
@@ -321,12 +554,13 @@ bool send(void) {
             static uint16_t tx_device_id=Settings_obj.GetTxDeviceId();
             static uint16_t rx_device_id=Settings_obj.GetRxDeviceId();
             static uint16_t mono_channel=Settings_obj.GetMonoChannel();
-            memset(Msg_message, 0, sizeof(Msg_message));
-            Msg_message[0]=tx_device_id;
-            Msg_message[1]=rx_device_id;
-            Msg_message[2]=mono_channel;
-            Msg_message[3]=read_pa_level_switch(PALEVEL0_GPIO, PALEVEL1_GPIO);
-            Msg_message[4]=Transceiver_obj.GetSessionKey();
+            uint16_t *message=Transceiver_obj.NextMsg()->message; // shortcut
+            memset(message, 0, sizeof(Transceiver_obj.NextMsg()->message));
+            message[0]=tx_device_id;
+            message[1]=rx_device_id;
+            message[2]=mono_channel;
+            message[3]=read_pa_level_switch(PALEVEL0_GPIO, PALEVEL1_GPIO);
+            message[4]=Transceiver_obj.GetSessionKey();
             Msg_type=Transceiver::DGT_SERVICE;
         }
     }
@@ -337,26 +571,15 @@ bool send(void) {
         Msg_type=Transceiver::DGT_USER;
 
         // switch to next radio channel
-        Transceiver_obj.SetChannel(Transceiver_obj.Msg_Datagram.number+1);
+        Transceiver_obj.SetChannel(Transceiver_obj.Msg_Datagram->number+1);
     }
 
-    // check actions on the Pairing button while in MONOFREQ
-    // pressing the Pairing button while in MULTIFREQ has no effect
-    if (Tx_state==MONOFREQ) { // else already paired
-        BtnStates btn_state=ReadBtn(PAIRING_GPIO, RUNLED_GPIO, 1500);
-        RunLedEnabled=(btn_state==BTN_RELEASED); // if btn_state==BTN_PRESSED then read_button() will control the Led
-        if (btn_state==BTN_REACHED_DURATION) {
-            // blink led for 3 seconds to tell user that he can release the button
-            unsigned long stop_time=millis()+3000;
-            while (millis()<stop_time)
-                BlinkLed(RUNLED_GPIO, 100, 50, false);
-            digitalWrite(RUNLED_GPIO, LOW);
-
-            // reconfigure the transceiver for pairing
-            dbprintln("Pairing");
-            PairingInProgress=true;
-            Transceiver_obj.Setup(true, Transceiver::DEF_TXID, Transceiver::DEF_RXID, Transceiver::DEF_MONOCHAN, Transceiver::DEF_PALEVEL);
-        }
+    // pairing requested with the Pairing button, see check_buttons()
+    if (PairingRequested && !PairingInProgress && Tx_state==MONOFREQ) {
+        // reconfigure the transceiver for pairing
+        dbprintln("Pairing");
+        PairingInProgress=true;
+        Transceiver_obj.Setup(true, Transceiver::DEF_TXID, Transceiver::DEF_RXID, Transceiver::DEF_MONOCHAN, Transceiver::DEF_PALEVEL);
     }
      return retval;
 }
@@ -11,6 +11,9 @@
 #include "Common.h" // for GPIOs definitions
 #include "Gpio.h"
 #include "User.h"
+#include "Message.h"
+#include "AdcSampler.h"
+#include "Mixer.h"
 
 #if DEBUG_ON == 2
 #include "rgSerialBT.h"
@@ -23,6 +26,9 @@
 #include <rgDebug.h>
 
 extern uint16_t ErrorCounter;  // number of transmission errors per second, updated once/second
+extern uint8_t IdlePercent;    // percentage of time spent waiting for the next slot, updated once/second
+extern AdcSampler AdcSampler_obj; // sampled continuously, latched by the base code before each call to UserLoopMsg()
+extern Mixer Mixer_obj;           // configured by the file /mixer.csv, see Mixer.h
 
 // User may add code after this line ------------------------------------------
 
@@ -32,17 +38,17 @@ const uint8_t DAC_GPIOS[]={USR_CHAN1_GPIO, USR_CHAN2_GPIO, USR_CHAN3_GPIO, USR_C
 // Read the switches values using these inputs
 const uint8_t BIN_GPIOS[]={USR_CHAN5_GPIO, USR_CHAN6_GPIO};
 
-// Values read in the ADC inputs will be converted to this range
-// (constants copied from ESP32Servo.h)
-const uint16_t  MIN_PULSE_WIDTH=500;    // the shortest pulse sent to a servo  
-const uint16_t  MAX_PULSE_WIDTH=2500;   // the longest pulse sent to a servo 
+// Values read in the ADC inputs go through the mixer, then its outputs are converted to the range of ServoPulse, see Message.h
+// the ADC samples the potentiometers continuously : 25 conversions per channel and per frame, 200 frames/s
+const uint8_t ADC_CONVERSIONS=25;
 
 // User setup code
 void UserSetup(int device_id) {
     trprintf("*** %s %s() begin\n", __FILE_NAME__, __FUNCTION__);
 
-    // set the ADC resolution to 10 bits (0-1023) for probing channels 1,2,3 (potentiometers)
-	analogReadResolution(10);
+    // start sampling channels 1,2,3,4 (potentiometers) with a 10 bits resolution (0-1023)
+    if (!AdcSampler_obj.Config(DAC_GPIOS, sizeof(DAC_GPIOS), 10, ADC_CONVERSIONS, 20000, false))
+        dbprintln("UserSetup: ADC error");
 
     // initialize the digital inputs (switches)
     for (uint8_t idx=0; idx<sizeof(BIN_GPIOS); idx++)
@@ -68,32 +74,53 @@ int UserLoopBegin(void) {
    set your outgoing message here
    it contains the data that is going to be transmitted to the receiver
    typically this data is a list of potentiometers/switches values or sensor readings
-   Update Transceiver.MSGVALUES to match your data length
-   Example message layout:
-   [0]  value of USR_CHAN1_GPIO (P1)
-   [1]  value of USR_CHAN2_GPIO (P2)
-   [2]  value of USR_CHAN3_GPIO (P3)
-   [3]  value of USR_CHAN4_GPIO (P4)
-   [4]  state of USR_CHAN5_GPIO (SW1)
-   [5]  state of USR_CHAN6_GPIO (SW2)
+   The layout of message is declared by MsgSchema in Message.h, which is shared with the receiver
+   message points directly into the next datagram to transmit, it is not cleared and still contains
+   the values of an older datagram : MsgSchema::Pack() sets all the values it uses
+   Example message layout (MsgSchema):
+   4 x ServoPulse   value of USR_CHAN1_GPIO to USR_CHAN4_GPIO (P1 to P4)
+   2 x SwitchState  state of USR_CHAN5_GPIO and USR_CHAN6_GPIO (SW1, SW2)
    // Return value: user defined
 */
 int UserLoopMsg(uint16_t *message) {
     //static uint16_t Debug_print_counter=0; Debug_print_counter++;
 
-    // Read the potentiometers
+    // Read the potentiometers : newest oversampled frame, latched before this call
+    int16_t inputs[Mixer::MAXINPUTS]={0};
+    bool adc_ready=true;
     for (uint8_t idx=0; idx<sizeof(DAC_GPIOS); idx++) {
-        uint16_t value=analogRead(DAC_GPIOS[idx]);
-        uint16_t pulse=map(value, 0, 1023, MIN_PULSE_WIDTH, MAX_PULSE_WIDTH);
-        message[idx]=pulse;
-        //if (Debug_print_counter%20==0) dbprintf("Chan%d=%d ", idx+1, pulse);
+        const AdcSampler::Values &values=AdcSampler_obj.GetLatched(idx);
+        if (values.frames==0)
+            adc_ready=false; // Config() failed, or no frame received yet
+        inputs[idx]=Mixer::Normalize(values.value, 0, 1023);
+    }
+    uint16_t pulse[sizeof(DAC_GPIOS)];
+    if (adc_ready) {
+        // Mix them, fixed point : the curves were precomputed when the mixer file was loaded
+        int16_t outputs[Mixer::MAXOUTPUTS];
+        Mixer_obj.Compute(inputs, outputs);
+        for (uint8_t idx=0; idx<sizeof(DAC_GPIOS); idx++) {
+            pulse[idx]=Mixer::Denormalize(outputs[idx], ServoPulse::MIN_VALUE, ServoPulse::MAX_VALUE); // clamped by Pack()
+            //if (Debug_print_counter%20==0) dbprintf("Chan%d=%d ", idx+1, pulse[idx]);
+        }
+    }
+    else {
+        // failsafe : neutral pulses, a value of 0 would be sent as the minimum pulse
+        static bool Warned=false;
+        if (!Warned) {
+            dbprintln("UserLoopMsg: no ADC frame, sending neutral pulses");
+            Warned=true;
+        }
+        for (uint8_t idx=0; idx<sizeof(DAC_GPIOS); idx++)
+            pulse[idx]=(ServoPulse::MIN_VALUE+ServoPulse::MAX_VALUE)/2;
     }
     // Read the switches
+    uint8_t state[sizeof(BIN_GPIOS)];
     for (uint8_t idx=0; idx<sizeof(BIN_GPIOS); idx++) {
-        uint8_t value=digitalRead(BIN_GPIOS[idx]);
-        message[idx+sizeof(DAC_GPIOS)]=value;
-        //if (Debug_print_counter%20==0) dbprintf("Chan%d=%d ", idx+sizeof(DAC_GPIOS)+1, value);
+        state[idx]=digitalRead(BIN_GPIOS[idx]);
+        //if (Debug_print_counter%20==0) dbprintf("Chan%d=%d ", idx+sizeof(DAC_GPIOS)+1, state[idx]);
     }
+    MsgSchema::Pack(message, pulse[0], pulse[1], pulse[2], pulse[3], state[0], state[1]);
     //if (Debug_print_counter%20==0) dbprintln("");
     return 0;
 }
@@ -102,9 +129,10 @@ int UserLoopMsg(uint16_t *message) {
    process your ACK datagram here
    the ACK datagram contains the data received from the receiver in response to the previous Msg_Datagram
    typically this data is a list of values related to the receiver state (reception error rate, sensor readings, battery charge)
-   Example message layout:
-   [0]  Receiver errors count
-   [1]  Receiver power supply voltage
+   The layout of message is declared by AckSchema in Message.h, which is shared with the receiver
+   Example message layout (AckSchema):
+   ErrorCount   Receiver errors count
+   Millivolts   Receiver power supply voltage
    // Return value: user defined
 */
 int UserLoopAck(uint16_t *message) {
@@ -112,9 +140,10 @@ int UserLoopAck(uint16_t *message) {
     static unsigned long Last_time=0; // ms
     if (millis()>=Last_time+1000) {
 #if DEBUG_ON
-        uint16_t rx_errors=message[0];  // Rx error count
-        uint16_t rx_voltage=message[1]; // Rx power supply voltage
-        dbtprintf("Tx %u errors, Rx %u errors, %u mV\n", ErrorCounter, rx_errors, rx_voltage);
+        uint16_t rx_errors;  // Rx error count
+        uint16_t rx_voltage; // Rx power supply voltage
+        AckSchema::Unpack(message, rx_errors, rx_voltage);
+        dbtprintf("Tx %u errors, Rx %u errors, %u mV, Tx idle %u%%\n", ErrorCounter, rx_errors, rx_voltage, IdlePercent);
 #endif
         Last_time=millis();
     }
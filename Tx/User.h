@@ -25,7 +25,7 @@ int UserLoopAck(uint16_t *message);
 // User may add code after this line ------------------------------------------
 
 // Example code: we use 4 potentiometers and 2 switches to control 4 servos and 2 Leds on the receiver
-// we have set COM_MSGVALUES and COM_ACKVALUES accordingly in the "Global settings" section of Common.h
+// the message layouts are declared in Message.h, COM_MSGVALUES and COM_ACKVALUES are set accordingly in Common.h
 
 #define USR_CHAN1_GPIO 36 // analog, connected to P1
 #define USR_CHAN2_GPIO 39 // analog, connected to P2
@@ -91,3 +91,145 @@ BtnStates ReadBtnBlock(uint8_t btn_gpio, uint8_t led_gpio, long max_duration) {
 	}
 	return retval;
 }
+
+/* Interrupt-driven API ******************************************************/
+
+// Declare a button, call this method before Begin()
+// long_press_ms : a BTN_LONG_PRESS event is queued when the button has been pressed this long
+// return value: the button number reported in the events, or -1 if there are too many buttons
+int rgBtnManager::Add(uint8_t gpio, unsigned long long_press_ms) {
+	if (mCount_int==MAXBUTTONS)
+		return -1;
+	Button *button_obj=&mButtons_array[mCount_int];
+	button_obj->manager=this;
+	button_obj->index=mCount_int;
+	button_obj->gpio=gpio;
+	button_obj->pressed=false;
+	button_obj->press_time=0;
+	button_obj->long_press_ms=long_press_ms;
+	button_obj->debounce_timer=NULL;
+	button_obj->long_press_timer=NULL;
+	return mCount_int++;
+}
+
+// Configure the GPIOs and start the interrupts
+// a button already pressed queues a BTN_PRESS event, then a BTN_LONG_PRESS event if it is held long enough
+// return value: true=success, false=out of memory
+bool rgBtnManager::Begin(void) {
+	mQueue_obj=xQueueCreate(QUEUE_SIZE, sizeof(BtnEvent));
+	if (mQueue_obj==NULL)
+		return false;
+	for (int idx=0; idx<mCount_int; idx++) {
+		Button *button_obj=&mButtons_array[idx];
+		pinMode(button_obj->gpio, INPUT_PULLUP);
+		button_obj->debounce_timer=xTimerCreate("BtnDebounce", pdMS_TO_TICKS(DEBOUNCE_MS), pdFALSE, button_obj, debounce_callback);
+		button_obj->long_press_timer=xTimerCreate("BtnLong", pdMS_TO_TICKS(button_obj->long_press_ms), pdFALSE, button_obj, long_press_callback);
+		if (button_obj->debounce_timer==NULL || button_obj->long_press_timer==NULL)
+			return false;
+		if (digitalRead(button_obj->gpio)==LOW) {
+			button_obj->pressed=true;
+			button_obj->press_time=millis();
+			push_event(button_obj, BTN_PRESS);
+			xTimerStart(button_obj->long_press_timer, 0);
+		}
+		attachInterruptArg(button_obj->gpio, isr, button_obj, CHANGE);
+	}
+	return true;
+}
+
+// the new duration applies from the next press
+void rgBtnManager::SetLongPress(uint8_t button, unsigned long long_press_ms) {
+	if (button<mCount_int)
+		mButtons_array[button].long_press_ms=long_press_ms;
+}
+
+// Get the oldest event
+// timeout_ms : 0=return at once, else wait this long for an event
+// return value: true=event_out contains an event, false=no event
+bool rgBtnManager::GetEvent(BtnEvent *event_out, unsigned long timeout_ms) {
+	return mQueue_obj && xQueueReceive(mQueue_obj, event_out, pdMS_TO_TICKS(timeout_ms))==pdTRUE;
+}
+
+// return value: the debounced state of the button
+bool rgBtnManager::IsPressed(uint8_t button) {
+	return button<mCount_int && mButtons_array[button].pressed;
+}
+
+// Event-driven version of ReadBtnBlock(), to be called at boot
+// if the button is released it returns BTN_RELEASED immediately
+// if the button is pressed it waits until the button is released, without polling :
+// - if the long press duration has been reached it returns BTN_REACHED_DURATION
+// - if the button has been released before it returns BTN_RELEASED
+// - LED behaviour is the same as ReadBtn() if led_gpio is non zero
+// the events of the other buttons received meanwhile are discarded
+BtnStates rgBtnManager::WaitRelease(uint8_t button, uint8_t led_gpio) {
+	const unsigned long LED_PERIOD=25; // ms
+	BtnStates retval=BTN_RELEASED;
+	bool pressed=IsPressed(button);
+	if (pressed && led_gpio)
+		digitalWrite(led_gpio, HIGH); // Led stays on until the long press duration is reached
+	bool led_state=HIGH;
+	while (pressed) {
+		BtnEvent event;
+		// flash the Led rapidly once the long press duration is reached
+		if (GetEvent(&event, retval==BTN_REACHED_DURATION ? LED_PERIOD : 1000)) {
+			if (event.button!=button)
+				continue;
+			if (event.type==BTN_LONG_PRESS)
+				retval=BTN_REACHED_DURATION;
+			else if (event.type==BTN_RELEASE)
+				pressed=false;
+		}
+		else if (led_gpio && retval==BTN_REACHED_DURATION) {
+			led_state=!led_state;
+			digitalWrite(led_gpio, led_state);
+		}
+	}
+	if (led_gpio)
+		digitalWrite(led_gpio, LOW);
+	return retval;
+}
+
+// GPIO interrupt : restart the debouncing timer, the button is read when the contacts are stable
+void IRAM_ATTR rgBtnManager::isr(void *arg) {
+	Button *button_obj=(Button *)arg;
+	BaseType_t higher_priority_task_woken=pdFALSE;
+	xTimerResetFromISR(button_obj->debounce_timer, &higher_priority_task_woken);
+	if (higher_priority_task_woken)
+		portYIELD_FROM_ISR();
+}
+
+// runs in the FreeRTOS timer task DEBOUNCE_MS after the last edge
+void rgBtnManager::debounce_callback(TimerHandle_t timer_obj) {
+	Button *button_obj=(Button *)pvTimerGetTimerID(timer_obj);
+	bool pressed=(digitalRead(button_obj->gpio)==LOW); // when button is pressed then gpio is LOW
+	if (pressed==button_obj->pressed)
+		return; // a glitch, or the bounces of a press and release shorter than DEBOUNCE_MS
+	button_obj->pressed=pressed;
+	if (pressed) {
+		button_obj->press_time=millis();
+		button_obj->manager->push_event(button_obj, BTN_PRESS);
+		// xTimerChangePeriod() also starts the timer
+		xTimerChangePeriod(button_obj->long_press_timer, pdMS_TO_TICKS(button_obj->long_press_ms), 0);
+	}
+	else {
+		xTimerStop(button_obj->long_press_timer, 0);
+		button_obj->manager->push_event(button_obj, BTN_RELEASE);
+	}
+}
+
+// runs in the FreeRTOS timer task long_press_ms after the press
+void rgBtnManager::long_press_callback(TimerHandle_t timer_obj) {
+	Button *button_obj=(Button *)pvTimerGetTimerID(timer_obj);
+	if (button_obj->pressed)
+		button_obj->manager->push_event(button_obj, BTN_LONG_PRESS);
+}
+
+// the event is lost if the queue is full
+void rgBtnManager::push_event(Button *button_obj, uint8_t type) {
+	BtnEvent event;
+	event.button=button_obj->index;
+	event.type=type;
+	event.duration=type==BTN_PRESS ? 0 : millis()-button_obj->press_time;
+	xQueueSend(mQueue_obj, &event, 0);
+}
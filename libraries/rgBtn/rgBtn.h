@@ -11,9 +11,68 @@
 #include <Arduino.h>
 
 #define BTNLIB_NAME	"rgBtn" // spaces not permitted
-#define BTNLIB_VERSION	"v1.0.0"
+#define BTNLIB_VERSION	"v1.1.0"
 
 enum BtnStates {BTN_PRESSED, BTN_RELEASED, BTN_REACHED_DURATION};
 
+// Polled API : one button only, the state is kept in function statics
 BtnStates ReadBtn(uint8_t btn_gpio, uint8_t led_gpio, long max_duration);
 BtnStates ReadBtnBlock(uint8_t btn_gpio, uint8_t led_gpio, long max_duration);
+
+/* Interrupt-driven API : several buttons, no polling
+   each edge on a button GPIO restarts the debouncing timer of this button, and the state of the button is read
+   when the timer expires : the contact bounces are ignored, and the events are queued by the FreeRTOS timer task
+   the buttons connect their GPIO to GND, the internal pull-up resistors are enabled
+   Example:
+	rgBtnManager Buttons_obj;
+	int Pairing_btn=Buttons_obj.Add(PAIRING_GPIO, 1500);
+	Buttons_obj.Begin();
+	...
+	BtnEvent event;
+	while (Buttons_obj.GetEvent(&event)) {
+		if (event.button==Pairing_btn && event.type==BTN_LONG_PRESS)
+			start_pairing();
+	}
+*/
+enum BtnEventTypes {BTN_PRESS, BTN_LONG_PRESS, BTN_RELEASE};
+
+struct BtnEvent {
+	uint8_t button;         // value returned by rgBtnManager::Add()
+	uint8_t type;           // enum BtnEventTypes
+	unsigned long duration; // ms since the button was pressed, 0 for BTN_PRESS
+};
+
+class rgBtnManager {
+	public:
+		static const int MAXBUTTONS=4;
+		static const int QUEUE_SIZE=8;   // events are lost if GetEvent() is not called for a long time
+		static const int DEBOUNCE_MS=20; // the state must be stable this long
+
+	private:
+		struct Button {
+			rgBtnManager *manager;
+			uint8_t index;
+			uint8_t gpio;
+			volatile bool pressed;         // debounced state
+			unsigned long press_time;      // millis() when pressed
+			unsigned long long_press_ms;
+			TimerHandle_t debounce_timer;
+			TimerHandle_t long_press_timer;
+		};
+		Button mButtons_array[MAXBUTTONS];
+		int mCount_int=0;
+		QueueHandle_t mQueue_obj=NULL;
+
+		static void IRAM_ATTR isr(void *arg);
+		static void debounce_callback(TimerHandle_t timer_obj);
+		static void long_press_callback(TimerHandle_t timer_obj);
+		void push_event(Button *button_obj, uint8_t type);
+
+	public:
+		int Add(uint8_t gpio, unsigned long long_press_ms);
+		bool Begin(void);
+		void SetLongPress(uint8_t button, unsigned long long_press_ms);
+		bool GetEvent(BtnEvent *event_out, unsigned long timeout_ms=0);
+		bool IsPressed(uint8_t button);
+		BtnStates WaitRelease(uint8_t button, uint8_t led_gpio);
+};
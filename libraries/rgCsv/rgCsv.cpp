@@ -1,5 +1,12 @@
 /* rgCsv.cpp
 ** 2024-08-09
+** 2026-10-18 single memory arena allocated by Allocate(), in-place parsing, Release() frees everything
+** 2026-10-18 Load() reads the file by blocks with rgCsvReader
+** 2026-10-18 Save() writes a temporary file then renames it, and skips the write if no cell has changed
+** 2026-10-18 the file system is accessed through rgCsvStorage
+** 2026-10-18 keyed mode with a hash index of the keys, 32-bit integer cells bounded to maxcellen, float getters
+** 2026-10-18 streaming row iterator rgCsvRows
+** 2026-10-18 parsing and formatting with the rgStr toolkit, no data is moved
 **
 ** Requirements:
 ** 	1) partition: Arduino IDE/Tools/Partition scheme/Default 4MB withs spiffs
@@ -23,56 +30,91 @@
 
 /* Public interface **********************************************************/
 
+/* call this method before Allocate() to replace the default storage backend (LittleFS on the board, POSIX files on a host)
+   storage_obj must remain valid while this object is used, NULL restores the default backend
+*/
+void rgCsv::SetStorage(rgCsvStorage *storage_obj) {
+	mStorage_obj=storage_obj ? storage_obj : &mDefaultStorage_obj;
+}
+
 /* call this method to allocate resources for this object
 	path_str 	absolute path or simple file name
 	maxlines_int	max number of data lines in the csv file (not counting blank lines and comments)
 	maxcells_int	max number of cells per line
 	maxcellen_int	max number of characters per cell (including leading and trailing spaces, if any)
 	create_bool		create the file if it does not exist
-   Prerequisite: the LittleFS file system is already formatted
-   This method mounts the LittleFS file system if it is not already mounted, but does not format it
+	keyed_bool		keyed mode : column 0 contains the keys, see GetInt(), maxlines_int must not exceed MAXKEYS
+   Prerequisite: the LittleFS file system is already formatted (on a host, the root directory of rgCsvPosix exists)
+   This method mounts the file system if it is not already mounted, but does not format it
     and returns error -1 if it has not been done yet
    The maximum length of a line in the csv file is (maxcells_int*maxcellen_int)+maxcells_int-1 including
    whitespace and comments ; if a line is too long then Load() will fail
+   All the memory used by this object is allocated here in a single block, Load() and Save() allocate nothing
    Return value: 0=success, -1=filesystem not found, -2=file not found if create_bool==false, -3=out of memory
 */
 int rgCsv::Allocate(const char *path_str, 
 	int maxlines_int, 
 	int maxcells_int, 
 	int maxcellen_int,
-	bool create_bool
+	bool create_bool,
+	bool keyed_bool
 ) {
 	int retval_int=0;
-	if (LittleFS.begin(false)) {
-		if (mPath_str || mCells)
+	if (mStorage_obj->Mount()) {
+		if (mArena)
 			Release();
-		mPath_str=(char *)calloc(strlen(path_str)+2, sizeof(char)); // +1 for the optional '/', +1 for the final '\0'
-		if (mPath_str) {
-			byte offset=0;
-			if (path_str[0]!='/') {
+		int cells_int=maxlines_int*maxcells_int;
+		if ((long)cells_int*(maxcellen_int+1)>=NO_STRING)
+			return -3; // the string offsets of the cells are 16 bits
+		if (keyed_bool && maxlines_int>MAXKEYS)
+			return -3; // the index stores the line numbers in 8 bits
+		// the index has at least twice as many slots as keys, and a power of 2 slots
+		int index_size=0;
+		if (keyed_bool) {
+			index_size=4;
+			while (index_size<2*maxlines_int)
+				index_size*=2;
+		}
+		size_t line_size=(maxcells_int*maxcellen_int)+maxcells_int;
+		// the members of the arena are ordered by decreasing alignment
+		size_t path_size=strlen(path_str)+2; // +1 for the optional '/', +1 for the final '\0'
+		size_t arena_size=maxcells_int*sizeof(char *)
+			+cells_int*sizeof(CELL)
+			+cells_int*(maxcellen_int+1)
+			+(cells_int+7)/8
+			+index_size
+			+line_size+1
+			+path_size
+			+path_size+strlen(TMP_SUFFIX);
+		mArena=calloc(arena_size, 1);
+		if (mArena) {
+			mCellPtrs_array=(char **)mArena;
+			mCells=(CELL *)(mCellPtrs_array+maxcells_int);
+			mStrings_str=(char *)(mCells+cells_int);
+			mDirty_array=(uint8_t *)(mStrings_str+cells_int*(maxcellen_int+1));
+			mIndex_array=mDirty_array+(cells_int+7)/8;
+			mIndexSize_int=index_size;
+			mLine_str=(char *)(mIndex_array+index_size);
+			mLineSize_int=line_size;
+			mPath_str=mLine_str+line_size+1;
+			if (path_str[0]!='/')
 				mPath_str[0]='/';
-				offset=1;
-			}
-			strncpy(mPath_str+offset, path_str, strlen(path_str));
-			if (LittleFS.exists(mPath_str) || create_bool) {
+			strcat(mPath_str, path_str);
+			mTmpPath_str=mPath_str+path_size;
+			strcpy(mTmpPath_str, mPath_str);
+			strcat(mTmpPath_str, TMP_SUFFIX);
+			//Serial.printf("debug: arena takes %d bytes\n", arena_size);
+
+			if (mStorage_obj->Exists(mPath_str) || create_bool) {
 				mMaxlines_int=maxlines_int;
 				mMaxcells_int=maxcells_int;
 				mMaxcellen_int=maxcellen_int;
-
-				mCells=(CELL *)calloc(mMaxlines_int*mMaxcells_int, sizeof(CELL));
-				if (mCells) {
-					for (int idx=0; idx<mMaxlines_int*mMaxcells_int; idx++) {
-						mCells[idx].value_int=0;
-						mCells[idx].value_str=NULL;
-					}
-					//Serial.printf("CELL is %d bytes\n", sizeof(CELL));
-					//Serial.printf("debug: mCells[] takes %d bytes\n", mMaxlines_int*mMaxcells_int*sizeof(CELL));
-				}
-				else 
-					retval_int=-3; // out of memory
+				clear_cells();
 			}
-			else
+			else {
+				Release();
 				retval_int=-2; // file not found
+			}
 		}
 		else 
 			retval_int=-3; // out of memory
@@ -86,19 +128,23 @@ int rgCsv::Allocate(const char *path_str,
    This method leaves the LittleFS file system mounted
 */
 void rgCsv::Release(void) {
-	if (mPath_str) {
-		free(mPath_str);
-		mPath_str=NULL;
-	}
-	if (mCells) {
-		for (int idx=0; idx<mMaxlines_int*mMaxcells_int; idx++) {
-			if (mCells[idx].value_str) {
-				free(mCells[idx].value_str);
-				mCells[idx].value_str=NULL;
-			}
-		}
-		mCells=NULL;
+	if (mArena) {
+		free(mArena);
+		mArena=NULL;
 	}
+	mCellPtrs_array=NULL;
+	mCells=NULL;
+	mStrings_str=NULL;
+	mDirty_array=NULL;
+	mIndex_array=NULL;
+	mIndexSize_int=0;
+	mLine_str=NULL;
+	mPath_str=NULL;
+	mTmpPath_str=NULL;
+	mLineSize_int=0;
+	mMaxlines_int=0;
+	mMaxcells_int=0;
+	mLines_int=0;
 }
 
 /*  Load the whole file in RAM
@@ -110,28 +156,27 @@ void rgCsv::Release(void) {
 	-5	MAXCELLENGTH overflow
 	-6	out of memory
 
-	zero-length values will be stored as Cell_struct {0, NULL}
+	zero-length values will be stored as Cell_struct {0, NO_STRING}
+	no memory is allocated : the lines are parsed in place in the arena allocated by Allocate()
 */
 int rgCsv::Load(void) {
     int retval_int=0;
 	int line_int=0;
 
-	const size_t Line_buffer_size=(mMaxcells_int*mMaxcellen_int)+mMaxcells_int;
-	char *linebuff_str=(char *)calloc(Line_buffer_size, sizeof(char));
-	char **cells_str_array=(char **)calloc(mMaxcells_int, sizeof(char **));
-	
-    if (linebuff_str && cells_str_array) {
-		File file_obj=LittleFS.open(mPath_str,"r");
-		if (file_obj) {
+	if (mArena) {
+		clear_cells();
+		if (mStorage_obj->Open(mPath_str,"r")) {
+			rgCsvReader reader_obj;
+			reader_obj.Begin(mStorage_obj);
 			int eof_int=0;
 			while (!eof_int && retval_int==0) {
-				switch (read_line(&file_obj, Line_buffer_size, linebuff_str)) {
+				switch (reader_obj.ReadLine(mLine_str, mLineSize_int+1)) {
 					case -2:
 						eof_int=1;
 						break; // EOF
 
 					case -1:
-						Serial.printf("debug: max line length is %d\n", Line_buffer_size-1);
+						//Serial.printf("debug: max line length is %d\n", mLineSize_int);
 						retval_int=-3; // line too long or missing '\n'
 						break;
 
@@ -140,41 +185,20 @@ int rgCsv::Load(void) {
 							retval_int=-2; // too many lines
 						else {
 							// ignore comments and blank lines
-							TrimCommentAndWhitespace(linebuff_str);
-							if (*linebuff_str) {
-								// parse the line
-								int result=parse(linebuff_str, cells_str_array, mMaxcells_int, mMaxcellen_int, ',');
+							char *line_str=SkipCommentAndWhitespace(mLine_str);
+							if (*line_str) {
+								// split the line in place, mCellPtrs_array points into mLine_str
+								int result=parse(line_str, mCellPtrs_array, mMaxcells_int, mMaxcellen_int, ',');
 								if (result >= 0) {
-									// copy cells_str_array to mCells
+									// copy the cells to mCells
 									for (int column_int=0; column_int<result; column_int++) {
-										char *this_cell=cells_str_array[column_int];
-										int value_length=strlen(this_cell);
-										if (value_length) {
-											// test if cell contains only digits
-											bool is_integer=true;
-											char *ptr=this_cell;
-											while (*ptr && is_integer) {
-												if (!isdigit((unsigned char)*ptr))
-													is_integer=false;
-												ptr++;
-											}
-											if (is_integer) {
-												// copy integer value to mCells
-												mCells[CELLIDX(line_int, column_int)].value_int=atoi(this_cell);
-												mCells[CELLIDX(line_int, column_int)].value_str=NULL;
-											}
-											else {
-												// copy string value to mCells
-												char *str=(char *)calloc(value_length+1, sizeof(char));
-												if (str) {
-													strncpy(str, this_cell, value_length);
-													mCells[CELLIDX(line_int, column_int)].value_str=str;
-													mCells[CELLIDX(line_int, column_int)].value_int=0;
-												}
-												else {
-													retval_int=-6; // out of memory
-													break;
-												}
+										const char *this_cell=mCellPtrs_array[column_int];
+										if (*this_cell) {
+											CELL *cell=&mCells[CELLIDX(line_int, column_int)];
+											if (!parse_int(this_cell, &cell->value_int)) {
+												// store the string directly, parse() has checked the length, and the index is built below
+												cell->value_offset=CELLIDX(line_int, column_int)*(mMaxcellen_int+1);
+												strcpy(mStrings_str+cell->value_offset, this_cell);
 											}
 										}
 									}
@@ -182,26 +206,18 @@ int rgCsv::Load(void) {
 								}
 								else 
 									retval_int=result-3;
-
-								// free the contents of cells_str_array but not the array itself
-								free_cells(cells_str_array, mMaxcells_int);
 							}
 						}
 						break;
 				}
 			}
-			file_obj.close();
+			mStorage_obj->Close();
 		}
 		else
 			retval_int=-1; // file not found
 	}
 	else
-		retval_int=-6; // out of memory
-
-	if (linebuff_str)
-		free(linebuff_str);
-	if (cells_str_array)
-		free(cells_str_array);
+		retval_int=-6; // out of memory : Allocate() failed or was not called
 
     if (retval_int == 0) {
         retval_int=line_int;
@@ -209,73 +225,100 @@ int rgCsv::Load(void) {
 	}
 	else
 		mLines_int=0;
+	if (mArena) {
+		clear_dirty(); // the cells match the file
+		build_index();
+	}
 
     return retval_int;
 }
 
-// return value: number of lines written, negative value on error  (do not modify these negative values)
-// lines_int optional, number of lines to save when creating a file (Load() was not called in this case, and mLines_int=0)
+/* Write the cells to the file
+   the lines are written to a temporary file, which then replaces the file : a power loss during Save() leaves
+   either the old file or the new file, but never a truncated file
+   the file is not written if no cell has been modified since Load() or since the last Save()
+   lines_int optional, number of lines to save when creating a file (Load() was not called in this case, and mLines_int=0)
+   return value: number of lines written (or number of lines if the file was not written), negative value on error
+	(do not modify these negative values)
+	-1	i/o error creating file
+	-2	i/o error writing data
+	-3	i/o error replacing the file
+*/
 int rgCsv::Save(int lines_int) {
 	int retval_int=0;
 	int line_int=0;
 	
 	if (lines_int>0)
 		mLines_int=lines_int;
+	else if (!IsDirty() && mStorage_obj->Exists(mPath_str))
+		return mLines_int; // nothing to write
 
-	// truncate existing file
-	LittleFS.remove(mPath_str);
-    File file_obj=LittleFS.open(mPath_str,"w");
-    if (file_obj) {
-		const size_t Line_buffer_size=(mMaxcells_int*mMaxcellen_int)+mMaxcells_int;
-		char *linebuff_str=(char *)calloc(Line_buffer_size, sizeof(char));
-		if (linebuff_str) {
-			int bufflen_int=0;
-			int column_int=0;
-			char integer_str[mMaxcellen_int+1]; // "-32767" takes 6 bytes
-			while (line_int < mLines_int) {
-				memset(linebuff_str, '\0', Line_buffer_size);
-				for (column_int=0; column_int<mMaxcells_int; column_int++) {
-					const char *str=NULL;
-					if (column_int>0)
-						strcat(linebuff_str, ",");
-					str=GetStrCell(line_int, column_int);
-					if (str)
-						strcat(linebuff_str, str);
-					else {
-						snprintf(integer_str, mMaxcellen_int, "%d", GetIntCell(line_int, column_int));
-						strcat(linebuff_str, integer_str);
-					}
+    if (mStorage_obj->Open(mTmpPath_str,"w")) {
+		char *linebuff_str=mLine_str;
+		int bufflen_int=0;
+		int column_int=0;
+		char integer_str[FORMATINT_SIZE];
+		const int maxlen_int=(int)mLineSize_int-1; // room left for the final '\n'
+		while (line_int < mLines_int) {
+			// the cells hold at most mMaxcellen_int characters, see SetIntCell() and SetStrCell()
+			// the copies are bounded anyway : mLineSize_int characters, including the commas and the final '\n'
+			bufflen_int=0;
+			for (column_int=0; column_int<mMaxcells_int; column_int++) {
+				const char *str=GetStrCell(line_int, column_int);
+				if (str==NULL) {
+					FormatInt(GetIntCell(line_int, column_int), integer_str);
+					str=integer_str;
 				}
-				bufflen_int=strlen(linebuff_str);
-				linebuff_str[bufflen_int]='\n';
-				linebuff_str[++bufflen_int]='\0';
-				int count_int=file_obj.write((const uint8_t *)linebuff_str, bufflen_int);
-				if (count_int!=bufflen_int) {
-					retval_int=-2; // i/o error writing data
-					break;
-				}
-				line_int++;
-				//Serial.printf("rgCsv::Save() line %d\n", line_int);
+				if (column_int>0 && bufflen_int<maxlen_int)
+					linebuff_str[bufflen_int++]=',';
+				while (*str && bufflen_int<maxlen_int)
+					linebuff_str[bufflen_int++]=*str++;
+			}
+			linebuff_str[bufflen_int++]='\n';
+			linebuff_str[bufflen_int]='\0';
+			int count_int=mStorage_obj->Write((const uint8_t *)linebuff_str, bufflen_int);
+			if (count_int!=bufflen_int) {
+				retval_int=-2; // i/o error writing data
+				break;
 			}
-			free(linebuff_str);
+			line_int++;
+			//Serial.printf("rgCsv::Save() line %d\n", line_int);
 		}
-		file_obj.close();
+		mStorage_obj->Close();
+		if (retval_int==0) {
+			// the backend replaces an existing file atomically
+			if (!mStorage_obj->Rename(mTmpPath_str, mPath_str))
+				retval_int=-3; // i/o error replacing the file
+		}
+		if (retval_int<0)
+			mStorage_obj->Remove(mTmpPath_str);
     }
     else {
-		//Serial.printf("rgCsv::Save() error creating file %s\n", mPath_str);
+		//Serial.printf("rgCsv::Save() error creating file %s\n", mTmpPath_str);
         retval_int=-1; // i/o error creating file
 	}
 
-    if (retval_int == 0)
+    if (retval_int == 0) {
         retval_int=line_int;
+		clear_dirty();
+	}
 
 	//Serial.printf("rgCsv::Save() returns %d\n", retval_int);
     return retval_int;
 }
 
-// return value: 0=success, <0 on error
-int16_t rgCsv::GetIntCell(byte line_int, byte column_int) {
-	int16_t retval_int=-1;
+// return value: true if a cell has been modified since Load() or since the last Save()
+bool rgCsv::IsDirty(void) {
+	for (int idx=0; idx<(mMaxlines_int*mMaxcells_int+7)/8; idx++) {
+		if (mDirty_array[idx])
+			return true;
+	}
+	return false;
+}
+
+// return value: the integer value of the cell (0 if the cell contains a string), -1 on error
+int32_t rgCsv::GetIntCell(byte line_int, byte column_int) {
+	int32_t retval_int=-1;
 	if (line_int<mMaxlines_int && column_int<mMaxcells_int)
 		retval_int=mCells[CELLIDX(line_int, column_int)].value_int;
 	//Serial.printf("GetIntCell(%d, %d) returns %d\n", line_int, column_int, retval_int);
@@ -283,12 +326,22 @@ int16_t rgCsv::GetIntCell(byte line_int, byte column_int) {
 }
 
 // if the cell contains an existing string value then this value will be NULLed
+// the decimal text of the value must fit in maxcellen_int characters, like a string cell, so that Save() can write it
 // return value: 0=success, <0 on error
-int rgCsv::SetIntCell(byte line_int, byte column_int, int16_t new_value_int) {
+int rgCsv::SetIntCell(byte line_int, byte column_int, int32_t new_value_int) {
 	int retval_int=0;
-	if (line_int<mMaxlines_int && column_int<mMaxcells_int) {
-		retval_int=SetStrCell(line_int, column_int, NULL);
-		mCells[CELLIDX(line_int, column_int)].value_int=new_value_int;
+	char integer_str[FORMATINT_SIZE];
+	if (FormatInt(new_value_int, integer_str)>mMaxcellen_int)
+		retval_int=-2; // value too long
+	else if (line_int<mMaxlines_int && column_int<mMaxcells_int) {
+		CELL *cell=&mCells[CELLIDX(line_int, column_int)];
+		if (cell->value_offset!=NO_STRING || cell->value_int!=new_value_int) {
+			cell->value_offset=NO_STRING;
+			cell->value_int=new_value_int;
+			set_dirty(CELLIDX(line_int, column_int));
+			if (column_int==0)
+				build_index(); // the key has changed
+		}
 	}
 	else
 		retval_int=-1; // index out of range
@@ -298,14 +351,18 @@ int rgCsv::SetIntCell(byte line_int, byte column_int, int16_t new_value_int) {
 // return value: 0=success, NULL on error
 const char *rgCsv::GetStrCell(byte line_int, byte column_int) {
 	const char *retval_str=NULL;
-	if (line_int<mMaxlines_int && column_int<mMaxcells_int)
-		retval_str=mCells[CELLIDX(line_int, column_int)].value_str;
+	if (line_int<mMaxlines_int && column_int<mMaxcells_int) {
+		uint16_t offset=mCells[CELLIDX(line_int, column_int)].value_offset;
+		if (offset!=NO_STRING)
+			retval_str=mStrings_str+offset;
+	}
 	//Serial.printf("GetStrCell(%d, %d) returns \"%s\"\n", line_int, column_int, retval_str);
 	return retval_str;
 }
 
 // if the cell contains an existing integer value then this value will be zeroed
-// a zero-length new_value_str or a NULL value will be stored as a Cell_struct {0, NULL}
+// a zero-length new_value_str or a NULL value will be stored as a Cell_struct {0, NO_STRING}
+// the string is copied to the slot of this cell in the arena, no memory is allocated
 // return value: 0=success, <0 on error
 int rgCsv::SetStrCell(byte line_int, byte column_int, const char *new_value_str) {
 	int retval_int=0;
@@ -315,141 +372,375 @@ int rgCsv::SetStrCell(byte line_int, byte column_int, const char *new_value_str)
 		if (new_value_str)
 			new_length=strlen(new_value_str);
 
-		char *str=mCells[CELLIDX(line_int, column_int)].value_str;
-		if (str)
-			free(str);
-		if (new_length) {
-			str=(char *)calloc(new_length+1, sizeof(char));
-			if (str)
-				strncpy(str, new_value_str, new_length);
-			else
-				retval_int=-2; // out of memory
+		if (new_length<=mMaxcellen_int) {
+			CELL *cell=&mCells[CELLIDX(line_int, column_int)];
+			const char *old_value_str=GetStrCell(line_int, column_int);
+			bool changed=new_length ? (old_value_str==NULL || strcmp(old_value_str, new_value_str)!=0) : (old_value_str!=NULL || cell->value_int!=0);
+			if (changed) {
+				cell->value_int=0;
+				if (new_length) {
+					cell->value_offset=CELLIDX(line_int, column_int)*(mMaxcellen_int+1);
+					memcpy(mStrings_str+cell->value_offset, new_value_str, new_length+1);
+				}
+				else
+					cell->value_offset=NO_STRING;
+				set_dirty(CELLIDX(line_int, column_int));
+				if (column_int==0)
+					build_index(); // the key has changed
+			}
 		}
 		else
-			str=NULL;
-		if (retval_int==0) {
-			mCells[CELLIDX(line_int, column_int)].value_str=str;
-			mCells[CELLIDX(line_int, column_int)].value_int=0;
-		}
+			retval_int=-2; // string too long
 	}
 	else
 		retval_int=-1; // index out of range
 	return retval_int;
 }
 
+// return value: the value of the cell converted to float (a string cell is converted with strtof()), 0 on error
+float rgCsv::GetFloatCell(byte line_int, byte column_int) {
+	float retval_flt=0;
+	const char *value_str=GetStrCell(line_int, column_int);
+	if (value_str)
+		retval_flt=strtof(value_str, NULL);
+	else if (line_int<mMaxlines_int && column_int<mMaxcells_int)
+		retval_flt=(float)GetIntCell(line_int, column_int);
+	return retval_flt;
+}
+
+/* Keyed mode ****************************************************************
+   Allocate(..., keyed_bool=true) : column 0 of each line contains a key, column 1 contains its value
+   Load() builds an index of the keys : the lines may be stored in any order, and a key is found in constant time
+   Example: file param.csv
+	TXID,64540
+	GAIN,0.85
+	NAME,basic
+	GetInt("TXID", -1) returns 64540, GetFloat("GAIN", 1.0) returns 0.85, GetStr("NAME", "") returns "basic"
+*/
+
+// return value: the line containing given key, or -1 if not found
+int rgCsv::FindKey(const char *key_str) {
+	int retval_int=-1;
+	if (mIndexSize_int && key_str && *key_str) {
+		int mask_int=mIndexSize_int-1;
+		for (int slot_int=hash(key_str) & mask_int; mIndex_array[slot_int]; slot_int=(slot_int+1) & mask_int) {
+			int line_int=mIndex_array[slot_int]-1;
+			const char *this_key_str=GetStrCell(line_int, 0);
+			if (this_key_str && strcmp(this_key_str, key_str)==0) {
+				retval_int=line_int;
+				break;
+			}
+		}
+	}
+	return retval_int;
+}
+
+// return value: the value of given key, or default_int if the key is not found
+int32_t rgCsv::GetInt(const char *key_str, int32_t default_int) {
+	int line_int=FindKey(key_str);
+	return line_int>=0 ? GetIntCell(line_int, 1) : default_int;
+}
+
+float rgCsv::GetFloat(const char *key_str, float default_flt) {
+	int line_int=FindKey(key_str);
+	return line_int>=0 ? GetFloatCell(line_int, 1) : default_flt;
+}
+
+// return value: the string value of given key, or default_str if the key is not found or its value is not a string
+const char *rgCsv::GetStr(const char *key_str, const char *default_str) {
+	int line_int=FindKey(key_str);
+	const char *retval_str=line_int>=0 ? GetStrCell(line_int, 1) : NULL;
+	return retval_str ? retval_str : default_str;
+}
+
+// set the value of given key, a new line is added if the key is not found
+// return value: 0=success, <0 on error (-3=too many lines, otherwise see SetIntCell())
+int rgCsv::SetInt(const char *key_str, int32_t new_value_int) {
+	char integer_str[FORMATINT_SIZE];
+	if (FormatInt(new_value_int, integer_str)>mMaxcellen_int)
+		return -2; // value too long, checked before a line is added for a new key
+	int line_int=add_key(key_str);
+	return line_int>=0 ? SetIntCell(line_int, 1, new_value_int) : line_int;
+}
+
+// the float value is stored as a string with 6 significant digits
+int rgCsv::SetFloat(const char *key_str, float new_value_flt) {
+	char value_str[16];
+	snprintf(value_str, sizeof(value_str), "%.6g", new_value_flt);
+	return SetStr(key_str, value_str);
+}
+
+int rgCsv::SetStr(const char *key_str, const char *new_value_str) {
+	int line_int=add_key(key_str);
+	return line_int>=0 ? SetStrCell(line_int, 1, new_value_str) : line_int;
+}
+
 
 /* Private implementation ****************************************************/
 
-/* Extract the CSV cells from given line into given array of strings
- * line_str is a string in csv format, containing no linebreaks
+// find given key, or add it to a new line after the last line
+// return value: the line containing the key, or <0 on error : -1=key empty or too long, or not in keyed mode -3=too many lines
+int rgCsv::add_key(const char *key_str) {
+	int retval_int=FindKey(key_str);
+	if (retval_int<0) {
+		if (mIndexSize_int==0 || key_str==NULL || *key_str=='\0')
+			retval_int=-1;
+		else if (mLines_int>=mMaxlines_int)
+			retval_int=-3; // too many lines
+		else {
+			retval_int=mLines_int++;
+			if (SetStrCell(retval_int, 0, key_str)<0) { // updates the index
+				mLines_int--;
+				retval_int=-1; // key too long
+			}
+		}
+	}
+	return retval_int;
+}
+
+// rebuild the index of the keys stored in column 0, a duplicate key is ignored
+void rgCsv::build_index(void) {
+	if (mIndexSize_int==0)
+		return;
+	memset(mIndex_array, 0, mIndexSize_int);
+	int mask_int=mIndexSize_int-1;
+	for (int line_int=0; line_int<mMaxlines_int; line_int++) {
+		const char *key_str=GetStrCell(line_int, 0);
+		if (key_str && FindKey(key_str)<0) {
+			int slot_int=hash(key_str) & mask_int;
+			while (mIndex_array[slot_int])
+				slot_int=(slot_int+1) & mask_int;
+			mIndex_array[slot_int]=line_int+1; // 0 is an empty slot
+		}
+	}
+}
+
+// FNV-1a hash of given key
+uint32_t rgCsv::hash(const char *key_str) {
+	uint32_t retval=2166136261UL;
+	while (*key_str) {
+		retval^=(uint8_t)*key_str++;
+		retval*=16777619UL;
+	}
+	return retval;
+}
+
+// convert a cell containing an optional '-' followed by digits to a 32-bit integer
+// return value: true=success, false=not an integer or out of range (the cell is then stored as a string)
+bool rgCsv::parse_int(const char *cell_str, int32_t *value_out) {
+	if (*cell_str=='+')
+		return false; // "+1" is kept as a string, Save() would write it back as "1"
+	StrSpan cell=MakeSpan(cell_str);
+	size_t used=0;
+	int32_t value_int=0;
+	if (ParseInt(cell, INT32_MIN, INT32_MAX, &value_int, &used)!=STR_PARSE_OK || used!=cell.len)
+		return false; // not a number, or followed by other characters
+	*value_out=value_int;
+	return true;
+}
+
+/* Split given line in place into CSV cells
+ * line_str is a string in csv format, containing no linebreaks : the separators are replaced by '\0'
+ *  and the leading and trailing whitespace of each cell is skipped
+ * cells_str_array_out receives pointers to the cells in line_str
  * max_cells maximum number of cells in the line
- * cell_size maximum length of a cell, not counting the final '\0'
+ * cell_size maximum length of a cell, including leading and trailing whitespace, not counting the final '\0'
  * cell_separator is the character between cells
  ** Return value: number of values stored in given cells_str_array_out, or negative on error:
  *	-1 max cells overflow
  *	-2 cell size overflow
- *  -3 out of memory
  */			
-int rgCsv::parse(const char *line_str, char **cells_str_array_out, const int max_cells, const int cell_size, const char cell_separator) {
+int rgCsv::parse(char *line_str, char **cells_str_array_out, const int max_cells, const int cell_size, const char cell_separator) {
 	int retval=0;
 	for (int idx=0; idx<max_cells; idx++)
 		cells_str_array_out[idx]=NULL;
 	if (*line_str) {
 		int cell_count=0;
-		int char_count=0;
-		const char *line_ptr=line_str;
-		char cell_buff[cell_size+1];
+		char *cell_ptr=line_str;
 		while (1) {
-			if (*line_ptr==cell_separator || *line_ptr=='\0') {
-				// acquire a cell
-				if (cell_count<max_cells) {
-					cell_buff[char_count]='\0';
-					TrimWhitespace(cell_buff);
-					char_count=strlen(cell_buff);
-					char *str=(char *)calloc(char_count+1, sizeof(char));
-					if (str) {
-						strncpy(str, cell_buff, char_count+1);
-						cells_str_array_out[cell_count]=str;
-						cell_count++;
-						if (*line_ptr=='\0') {
-							retval=cell_count;
-							break;
-						}
-						char_count=0;
-					}
-					else {
-						retval=-3; // out of memory
-						break;
-					}
-				}
-				else {
-					retval=-1; // max cells overflow
-					break;
-				}
+			char *end_ptr=strchr(cell_ptr, cell_separator);
+			bool last_cell=(end_ptr==NULL);
+			if (last_cell)
+				end_ptr=cell_ptr+strlen(cell_ptr);
+			if (cell_count==max_cells) {
+				retval=-1; // max cells overflow
+				break;
 			}
-			else {
-				// acquire a character
-				if (char_count<cell_size)
-					cell_buff[char_count++]=*line_ptr;
-				else {
-					retval=-2; // cell size overflow
-					break;
-				}
+			if (end_ptr-cell_ptr>cell_size) {
+				retval=-2; // cell size overflow
+				break;
+			}
+			// trim the cell in place, the characters are not moved
+			*end_ptr='\0';
+			StrSpan cell=TrimSpan({cell_ptr, (size_t)(end_ptr-cell_ptr)});
+			char *first_ptr=cell_ptr+(cell.ptr-cell_ptr);
+			first_ptr[cell.len]='\0';
+			cells_str_array_out[cell_count++]=first_ptr;
+			if (last_cell) {
+				retval=cell_count;
+				break;
 			}
-			line_ptr++;
+			cell_ptr=end_ptr+1;
 		}
 	}
 	return retval;
 }
 
-// free the contents of cells_str_array_out but not the array itself
-// parse() has allocated the memory of theses cells
-void rgCsv::free_cells(char **cells_str_array_out, const int max_cells) {
-	for (int idx=0; idx<max_cells; idx++) {
-		if (cells_str_array_out[idx]) {
-			free(cells_str_array_out[idx]);
-			cells_str_array_out[idx]=NULL;
+// reset all the cells to {0, NO_STRING}
+void rgCsv::clear_cells(void) {
+	for (int idx=0; idx<mMaxlines_int*mMaxcells_int; idx++) {
+		mCells[idx].value_int=0;
+		mCells[idx].value_offset=NO_STRING;
+	}
+}
+
+void rgCsv::set_dirty(int cell_idx) {
+	mDirty_array[cell_idx/8]|=1<<(cell_idx%8);
+}
+
+void rgCsv::clear_dirty(void) {
+	memset(mDirty_array, 0, (mMaxlines_int*mMaxcells_int+7)/8);
+}
+
+
+/* Streaming row iterator ****************************************************/
+
+// call this method before Open() to replace the default storage backend, NULL restores the default backend
+void rgCsvRows::SetStorage(rgCsvStorage *storage_obj) {
+	mStorage_obj=storage_obj ? storage_obj : &mDefaultStorage_obj;
+}
+
+// Open the file, the first row is read by Next()
+// path_str 	absolute path or simple file name
+// return value: 0=success, -1=filesystem not found, -2=file not found
+int rgCsvRows::Open(const char *path_str) {
+	int retval_int=0;
+	Close();
+	if (mStorage_obj->Mount()) {
+		// mLine_str is not in use yet, build the absolute path there
+		snprintf(mLine_str, sizeof(mLine_str), "%s%s", path_str[0]=='/' ? "" : "/", path_str);
+		if (mStorage_obj->Open(mLine_str, "r")) {
+			mReader_obj.Begin(mStorage_obj);
+			mOpen_bool=true;
 		}
+		else
+			retval_int=-2; // file not found
 	}
+	else
+		retval_int=-1; // filesystem not found
+	*mLine_str='\0';
+	return retval_int;
+}
 
+/*  Read the next row, comments and blank lines are skipped
+	Return value : number of cells of the row, 0 at the end of the file, or a negative value on error
+	-3	line too long or missing newline
+	-4	MAXCELLS overflow
+	-6	file not open
+	the error codes are those of rgCsv::Load(), the line causing the error is given by Line()
+*/
+int rgCsvRows::Next(void) {
+	int retval_int=0;
+	mCount_int=0;
+	if (!mOpen_bool)
+		return -6;
+	while (retval_int==0) {
+		int length_int=mReader_obj.ReadLine(mLine_str, sizeof(mLine_str));
+		if (length_int==-2)
+			break; // EOF
+		mLine_int++;
+		if (length_int==-1)
+			retval_int=-3; // line too long or missing '\n'
+		else {
+			char *line_str=SkipCommentAndWhitespace(mLine_str);
+			if (*line_str) {
+				int result=rgCsv::parse(line_str, mCells_array, MAXCELLS, LINE_SIZE, ',');
+				if (result>=0)
+					retval_int=mCount_int=result;
+				else
+					retval_int=result-3;
+			}
+		}
+	}
+	return retval_int;
+}
+
+void rgCsvRows::Close(void) {
+	if (mOpen_bool) {
+		mStorage_obj->Close();
+		mOpen_bool=false;
+	}
+	mCount_int=0;
+	mLine_int=0;
+}
+
+// return value: the cell of the current row, "" if the cell is empty, NULL if the column does not exist
+const char *rgCsvRows::GetStr(int column_int) {
+	return column_int>=0 && column_int<mCount_int ? mCells_array[column_int] : NULL;
 }
 
-// Read a line in given file and store it into given buffer
-// buffer must have room to store the terminating '\0' char
+// return value: the integer value of the cell, or default_int if the cell does not exist or is not an integer
+int32_t rgCsvRows::GetInt(int column_int, int32_t default_int) {
+	int32_t retval_int=default_int;
+	const char *value_str=GetStr(column_int);
+	if (value_str)
+		rgCsv::parse_int(value_str, &retval_int);
+	return retval_int;
+}
+
+// return value: the value of the cell converted with strtof(), or default_flt if the cell does not exist or is empty
+float rgCsvRows::GetFloat(int column_int, float default_flt) {
+	const char *value_str=GetStr(column_int);
+	return value_str && *value_str ? strtof(value_str, NULL) : default_flt;
+}
+
+/* Buffered line reader ******************************************************/
+
+// call this method after opening the file with storage_obj->Open(), before the first call to ReadLine()
+void rgCsvReader::Begin(rgCsvStorage *storage_obj) {
+	mStorage_obj=storage_obj;
+	mStart_int=0;
+	mEnd_int=0;
+}
+
+// Read the next line of the file and store it into given buffer
 // buffer_size_int is the total length, including the terminating '\0'
-// any '\r' is ignored, '\n' is not copied to the buffer
+// a '\r' before the '\n' is ignored, '\n' is not copied to the buffer
 // Return values:
 // * length of the line in given buffer (may be 0) if the line was read correctly
-// * or -1 and strlen(buffer)>0 if the line was too long to fit in the buffer or if we read
+// * or -1 if the line was too long to fit in the buffer or if we read
 //     the last line of the file and it was not terminated by '\n'
-//     whatever data was read is available in the buffer
 // * or -2 and strlen(buffer)=0 on EOF 
-int rgCsv::read_line(File *file_obj, int buffer_size_int, char *buffer_out_str) {
-	int retval_int=-1;
-	int char_counter_int=0;
-	char *buffer_ptr=buffer_out_str;
-	memset(buffer_out_str, '\0', buffer_size_int);
-	while (file_obj->available()) {
-		if (char_counter_int < buffer_size_int) {
-			char this_char=file_obj->read();
-			if (this_char!='\r') {
-				if (this_char=='\n') {
-					retval_int=char_counter_int;
-					break;
-				}
-				else {
-					*buffer_ptr++=this_char;
-					char_counter_int++;
-				}
-			}
-		}
-		else {
-			retval_int=-1; // '\n' not found before end of buffer
-			break;
+int rgCsvReader::ReadLine(char *buffer_out_str, int buffer_size_int) {
+	int length_int=0;
+	*buffer_out_str='\0';
+	while (true) {
+		if (mStart_int==mEnd_int && !fill())
+			return length_int ? -1 : -2; // EOF, -1 if the last line is not terminated by '\n'
+		const uint8_t *start_ptr=mBlock+mStart_int;
+		int available_int=mEnd_int-mStart_int;
+		const uint8_t *newline_ptr=(const uint8_t *)memchr(start_ptr, '\n', available_int);
+		int count_int=newline_ptr ? newline_ptr-start_ptr : available_int;
+		if (length_int+count_int>=buffer_size_int)
+			return -1; // '\n' not found before end of buffer
+		memcpy(buffer_out_str+length_int, start_ptr, count_int);
+		length_int+=count_int;
+		buffer_out_str[length_int]='\0';
+		mStart_int+=count_int;
+		if (newline_ptr) {
+			mStart_int++; // skip '\n'
+			if (length_int && buffer_out_str[length_int-1]=='\r')
+				buffer_out_str[--length_int]='\0';
+			return length_int;
 		}
 	}
-	if (retval_int==-1 && char_counter_int==0)
-		retval_int=-2; // EOF
-	//Serial.printf("read_line() \"%s\"\t(%d)\n", buffer_out_str, retval_int);
-	return retval_int;
+}
+
+// read the next block of the file
+// return value: true=success, false=EOF or read error
+bool rgCsvReader::fill(void) {
+	int count_int=mStorage_obj->Read(mBlock, BLOCK_SIZE);
+	mStart_int=0;
+	mEnd_int=count_int>0 ? count_int : 0;
+	return mEnd_int>0;
 }
@@ -1,5 +1,11 @@
 /* rgCsv.h
 ** 2024-08-11
+** 2026-10-18 single memory arena, in-place parsing
+** 2026-10-18 buffered block reader rgCsvReader
+** 2026-10-18 atomic Save(), dirty cells tracking
+** 2026-10-18 storage backends, runs on a Linux host with the POSIX backend
+** 2026-10-18 keyed mode, 32-bit integer cells, float getters
+** 2026-10-18 streaming row iterator rgCsvRows
 */
 
 /* This program is published under the GNU General Public License. 
@@ -14,14 +20,20 @@
 */
 
 #pragma once
-#include <LittleFS.h>
+#include <stddef.h>
+#include "rgCsvStorage.h"
+#ifndef ARDUINO
+typedef uint8_t byte;
+#endif
 
 #define CSVLIB_NAME	"rgCsv" // spaces not permitted
-#define CSVLIB_VERSION	"v1.5.0"
+#define CSVLIB_VERSION	"v2.1.0"
 
 /*******************************************
 * How to emulate library rgParam with rgCsv
 ********************************************
+The keyed mode is simpler, see Allocate(..., keyed_bool=true) and GetInt() ;
+the positional access below is still supported
 Example: file param.csv contains 3 parameters
 	# Application parameters
 	# Line length 25 chr max
@@ -47,34 +59,147 @@ Declare this in your sketch:
 	#define PARAMSETINT(x,v)	SetIntCell((byte)Paramid::x, 1, (v))
 */
 
+/* Buffered line reader
+   reads the file by blocks of BLOCK_SIZE bytes and finds the line ends with memchr(),
+   instead of reading the file one character at a time through the file system layers
+*/
+class rgCsvReader {
+	public:
+		static const int BLOCK_SIZE=512;
+
+	private:
+		rgCsvStorage *mStorage_obj=NULL;
+		uint8_t mBlock[BLOCK_SIZE];
+		int mStart_int=0; // first unread byte in mBlock
+		int mEnd_int=0;   // end of the data in mBlock
+
+		bool fill(void);
+
+	public:
+		void Begin(rgCsvStorage *storage_obj);
+		int ReadLine(char *buffer_out_str, int buffer_size_int);
+};
+
 class rgCsv {
 	private:
+#ifdef ARDUINO
+		rgCsvLittleFS mDefaultStorage_obj;
+#else
+		rgCsvPosix mDefaultStorage_obj;
+#endif
+		rgCsvStorage *mStorage_obj=&mDefaultStorage_obj;
 		char *mPath_str=NULL;
 		int mMaxlines_int=0;
 		int mMaxcells_int=0;
 		int mMaxcellen_int=0;
 		
 		// either one of the two members of this structure contains a value, but not both
+		// value_offset is the position of the string value in mStrings_str, or NO_STRING
+		static const uint16_t NO_STRING=0xFFFF;
+		static constexpr const char *TMP_SUFFIX=".tmp";
 		struct Cell_struct {
-			int16_t value_int;
-			char *value_str;
+			int32_t value_int;
+			uint16_t value_offset;
 		};
 		typedef struct Cell_struct CELL;
 		
-		CELL *mCells; // an array of CELL structures
+		/* All the memory is allocated at once by Allocate() and freed by Release(), this arena contains:
+			mCellPtrs_array	pointers to the cells of the line being parsed
+			mCells			array of CELL structures, mMaxlines_int*mMaxcells_int
+			mStrings_str	string values, one slot of mMaxcellen_int+1 chars per cell
+			mDirty_array	one bit per cell, set when the cell is modified
+			mIndex_array	keyed mode only, hash table of the keys : line number+1 of each key, 0=empty slot
+			mLine_str		line buffer used by Load() and Save()
+			mPath_str		absolute path of the file
+			mTmpPath_str	absolute path of the temporary file written by Save()
+		*/
+		void *mArena=NULL;
+		char **mCellPtrs_array=NULL;
+		CELL *mCells=NULL;
+		char *mStrings_str=NULL;
+		uint8_t *mDirty_array=NULL;
+		uint8_t *mIndex_array=NULL;
+		int mIndexSize_int=0; // number of slots of mIndex_array, a power of 2, 0 if not in keyed mode
+		char *mLine_str=NULL;
+		char *mTmpPath_str=NULL;
+		size_t mLineSize_int=0; // size of mLine_str, not counting the final '\0'
 		int mLines_int=0; // number of lines stored in mCells[] by Load()
 
-		int parse(const char *line_str, char **cells_str_array_out, const int max_cells, const int cell_size, const char cell_separator);
-		void free_cells(char **cells_str_array_out, const int max_cells);
-		int read_line(File *file_obj, int buffer_size_int, char *buffer_out_str);
+		static int parse(char *line_str, char **cells_str_array_out, const int max_cells, const int cell_size, const char cell_separator);
+		void clear_cells(void);
+		void set_dirty(int cell_idx);
+		void clear_dirty(void);
+		int add_key(const char *key_str);
+		void build_index(void);
+		static uint32_t hash(const char *key_str);
+		static bool parse_int(const char *cell_str, int32_t *value_out);
+
+		friend class rgCsvRows; // shares parse() and parse_int()
 
 	public:
-		int Allocate(const char *path_str, int maxlines_int, int maxcells_int, int maxcellen_int, bool create_bool);
+		void SetStorage(rgCsvStorage *storage_obj);
+		static const int MAXKEYS=254; // max number of lines in keyed mode
+
+		int Allocate(const char *path_str, int maxlines_int, int maxcells_int, int maxcellen_int, bool create_bool, bool keyed_bool=false);
 		void Release(void);
 		int Load(void);
 		int Save(int lines_int=0);
-		int16_t GetIntCell(byte line_int, byte column_int);
-		int SetIntCell(byte line_int, byte column_int, int16_t new_value_int);
+		bool IsDirty(void);
+		int32_t GetIntCell(byte line_int, byte column_int);
+		int SetIntCell(byte line_int, byte column_int, int32_t new_value_int);
+		float GetFloatCell(byte line_int, byte column_int);
 		const char *GetStrCell(byte line_int, byte column_int);
 		int SetStrCell(byte line_int, byte column_int, const char *new_value_str);
+
+		// keyed mode
+		int FindKey(const char *key_str);
+		int32_t GetInt(const char *key_str, int32_t default_int=-1);
+		float GetFloat(const char *key_str, float default_flt=0);
+		const char *GetStr(const char *key_str, const char *default_str=NULL);
+		int SetInt(const char *key_str, int32_t new_value_int);
+		int SetFloat(const char *key_str, float new_value_flt);
+		int SetStr(const char *key_str, const char *new_value_str);
+};
+
+/* Streaming row iterator
+   reads the file one line at a time : the memory used does not depend on the length of the file,
+   use it for the files too large to be loaded by rgCsv, eg lookup tables
+   the cells of the current row point into mLine_str and remain valid until the next call to Next()
+   Example:
+	rgCsvRows rows_obj;
+	if (rows_obj.Open("/curve.csv")==0) {
+		while (rows_obj.Next()>0)
+			table[rows_obj.GetInt(0, 0)]=rows_obj.GetFloat(1, 0.0);
+		rows_obj.Close();
+	}
+*/
+class rgCsvRows {
+	public:
+		static const int MAXCELLS=16;   // max number of cells per line
+		static const int LINE_SIZE=160; // max length of a line, including whitespace and comments
+
+	private:
+#ifdef ARDUINO
+		rgCsvLittleFS mDefaultStorage_obj;
+#else
+		rgCsvPosix mDefaultStorage_obj;
+#endif
+		rgCsvStorage *mStorage_obj=&mDefaultStorage_obj;
+		rgCsvReader mReader_obj;
+		bool mOpen_bool=false;
+		char mLine_str[LINE_SIZE+1];
+		char *mCells_array[MAXCELLS];
+		int mCount_int=0; // number of cells of the current row
+		int mLine_int=0;  // line number of the current row in the file, starting at 1
+
+	public:
+		void SetStorage(rgCsvStorage *storage_obj);
+		int Open(const char *path_str);
+		int Next(void);
+		void Close(void);
+		int Count(void) { return mCount_int; }
+		int Line(void) { return mLine_int; }
+		const char *GetStr(int column_int);
+		int32_t GetInt(int column_int, int32_t default_int=-1);
+		float GetFloat(int column_int, float default_flt=0);
 };
@@ -0,0 +1,252 @@
+/* rgCsvLog.cpp
+** 2026-10-18 append-only buffered CSV writer
+*/
+
+/* This program is published under the GNU General Public License.
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+#include "rgStr.h"
+#include "rgCsvLog.h"
+#ifndef ARDUINO
+#include <time.h>
+#endif
+
+/* Public interface **********************************************************/
+
+// call this method before Begin() to replace the default storage backend, NULL restores the default backend
+void rgCsvLog::SetStorage(rgCsvStorage *storage_obj) {
+	mStorage_obj=storage_obj ? storage_obj : &mDefaultStorage_obj;
+}
+
+/* call this method to allocate the pages and open the log
+	path_str			absolute path or simple file name, the file is created if it does not exist
+	page_size_int		size of each of the 2 pages, at least ROW_SIZE
+	flush_bytes_int		write the active page when it holds this number of bytes (at most page_size_int)
+	flush_ms_lng		write the active page when its first row is older than this, 0=disabled
+	max_file_bytes_lng	rotate the file when it would exceed this size, 0=never rotate
+	max_files_int		number of rotated files kept, <path>.1 to <path>.<max_files_int>
+   Return value: 0=success, -1=filesystem not found, -2=file creation error, -3=out of memory or invalid size
+*/
+int rgCsvLog::Begin(const char *path_str, int page_size_int, int flush_bytes_int, unsigned long flush_ms_lng,
+	long max_file_bytes_lng, int max_files_int
+) {
+	int retval_int=0;
+	End();
+	if (page_size_int<ROW_SIZE || max_files_int<0 || max_files_int>99)
+		return -3;
+	if (!mStorage_obj->Mount())
+		return -1;
+
+	size_t path_size=strlen(path_str)+2; // +1 for the optional '/', +1 for the final '\0'
+	mRotatePathSize_int=path_size+3; // ".99"
+	mMemory=(char *)calloc(2*page_size_int+path_size+2*mRotatePathSize_int, 1);
+	if (mMemory) {
+		mPages_array[0]=mMemory;
+		mPages_array[1]=mMemory+page_size_int;
+		mPath_str=mPages_array[1]+page_size_int;
+		if (path_str[0]!='/')
+			mPath_str[0]='/';
+		strcat(mPath_str, path_str);
+		mRotatePath_str=mPath_str+path_size;
+		mPageSize_int=page_size_int;
+		mFlushBytes_int=flush_bytes_int<page_size_int ? flush_bytes_int : page_size_int;
+		mFlushMs_lng=flush_ms_lng;
+		mMaxFileBytes_lng=max_file_bytes_lng;
+		mMaxFiles_int=max_files_int;
+		mActive_int=0;
+		mLength_int=0;
+		mPending_int=-1;
+		mDropped_int=0;
+		mError_int=0;
+		mStop_bool=false;
+
+		// create the file if needed and get its size
+		if (mStorage_obj->Open(mPath_str, "a")) {
+			mFileBytes_lng=mStorage_obj->Size();
+			mStorage_obj->Close();
+#ifdef ARDUINO
+			// low priority : the pages are written when the radio and the user code are idle
+			if (xTaskCreate(writer_task, "rgCsvLog", 4096, this, tskIDLE_PRIORITY+1, (TaskHandle_t *)&mTask_obj)!=pdPASS)
+				retval_int=-3;
+#endif
+		}
+		else
+			retval_int=-2; // file creation error
+		if (retval_int<0)
+			End();
+	}
+	else
+		retval_int=-3; // out of memory
+	return retval_int;
+}
+
+/* Format a row like printf() and append it to the active page, a '\n' is added
+   the row is truncated to ROW_SIZE-1 characters
+   this method does not access the file system on the ESP32 and returns in a few µs
+   Return value: 0=success, -1=Begin() not called, -2=the row was dropped because both pages are full
+*/
+int rgCsvLog::AppendRow(const char *format_str, ...) {
+	if (mMemory==NULL)
+		return -1;
+	char row_str[ROW_SIZE];
+	va_list args;
+	va_start(args, format_str);
+	int length_int=vsnprintf(row_str, ROW_SIZE-1, format_str, args); // keep room for '\n'
+	va_end(args);
+	if (length_int<0)
+		length_int=0;
+	else if (length_int>ROW_SIZE-2)
+		length_int=ROW_SIZE-2; // truncated
+	row_str[length_int++]='\n';
+
+	if (mLength_int+length_int>mPageSize_int && !submit()) {
+		mDropped_int++;
+		return -2; // the other page is still being written
+	}
+	if (mLength_int==0)
+		mFirstRowMs_lng=now_ms();
+	memcpy(mPages_array[mActive_int]+mLength_int, row_str, length_int);
+	mLength_int+=length_int;
+	if (mLength_int>=mFlushBytes_int)
+		submit(); // if the other page is still being written, the active page is submitted by the next call
+	else
+		Poll();
+	return 0;
+}
+
+// Write the active page if its first row is older than flush_ms
+// AppendRow() calls this method, call it also when no row is appended for a while
+void rgCsvLog::Poll(void) {
+	if (mMemory && mLength_int && mFlushMs_lng && now_ms()-mFirstRowMs_lng>=mFlushMs_lng)
+		submit();
+}
+
+/* Write all the rows to the file and wait until they are written
+   do not call this method from time critical code
+   Return value: 0=success, <0 if a page could not be written since Begin() : -1=file open error, -2=write error
+*/
+int rgCsvLog::Flush(void) {
+	if (mMemory) {
+		while (mLength_int && !submit()) {
+#ifdef ARDUINO
+			vTaskDelay(1); // wait for the writer task
+#endif
+		}
+		while (mPending_int>=0) {
+#ifdef ARDUINO
+			vTaskDelay(1);
+#endif
+		}
+	}
+	return mError_int;
+}
+
+// Write all the rows, stop the writer task and free the memory
+void rgCsvLog::End(void) {
+	if (mMemory) {
+		Flush();
+#ifdef ARDUINO
+		if (mTask_obj) {
+			mStop_bool=true;
+			xTaskNotifyGive(mTask_obj);
+			while (mTask_obj)
+				vTaskDelay(1);
+		}
+#endif
+		free(mMemory);
+		mMemory=NULL;
+	}
+	mPages_array[0]=NULL;
+	mPages_array[1]=NULL;
+	mPath_str=NULL;
+	mRotatePath_str=NULL;
+	mLength_int=0;
+}
+
+/* Private implementation ****************************************************/
+
+// hand the active page over to the writer and continue with the other page
+// return value: true=success, false=the other page is still being written
+bool rgCsvLog::submit(void) {
+	if (mPending_int>=0)
+		return false;
+	mPendingLength_int=mLength_int;
+	mPending_int=mActive_int; // the page belongs to the writer from now on
+	mActive_int^=1;
+	mLength_int=0;
+#ifdef ARDUINO
+	xTaskNotifyGive(mTask_obj);
+#else
+	write_page();
+#endif
+	return true;
+}
+
+// append the pending page to the file, the file is closed after each page
+void rgCsvLog::write_page(void) {
+	int page_int=mPending_int;
+	if (page_int<0)
+		return;
+	if (mMaxFileBytes_lng && mFileBytes_lng && mFileBytes_lng+mPendingLength_int>mMaxFileBytes_lng)
+		rotate();
+	if (mStorage_obj->Open(mPath_str, "a")) {
+		if (mStorage_obj->Write((const uint8_t *)mPages_array[page_int], mPendingLength_int)==mPendingLength_int)
+			mFileBytes_lng+=mPendingLength_int;
+		else
+			mError_int=-2; // write error
+		mStorage_obj->Close();
+	}
+	else
+		mError_int=-1; // file open error
+	mPending_int=-1; // the page belongs to AppendRow() again
+}
+
+// <path>.<max_files> is removed, <path>.<n> is renamed <path>.<n+1>, <path> is renamed <path>.1
+void rgCsvLog::rotate(void) {
+	char *old_path_str=mRotatePath_str;
+	char *new_path_str=mRotatePath_str+mRotatePathSize_int;
+	if (mMaxFiles_int==0)
+		mStorage_obj->Remove(mPath_str);
+	else {
+		snprintf(old_path_str, mRotatePathSize_int, "%s.%d", mPath_str, mMaxFiles_int);
+		mStorage_obj->Remove(old_path_str);
+		for (int idx=mMaxFiles_int-1; idx>=1; idx--) {
+			snprintf(old_path_str, mRotatePathSize_int, "%s.%d", mPath_str, idx);
+			snprintf(new_path_str, mRotatePathSize_int, "%s.%d", mPath_str, idx+1);
+			if (mStorage_obj->Exists(old_path_str))
+				mStorage_obj->Rename(old_path_str, new_path_str);
+		}
+		snprintf(new_path_str, mRotatePathSize_int, "%s.1", mPath_str);
+		mStorage_obj->Rename(mPath_str, new_path_str);
+	}
+	mFileBytes_lng=0;
+}
+
+#ifdef ARDUINO
+// write the pages submitted by AppendRow(), until End() is called
+void rgCsvLog::writer_task(void *parameters) {
+	rgCsvLog *log_obj=(rgCsvLog *)parameters;
+	while (!log_obj->mStop_bool) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		log_obj->write_page();
+	}
+	log_obj->mTask_obj=NULL;
+	vTaskDelete(NULL);
+}
+
+unsigned long rgCsvLog::now_ms(void) {
+	return millis();
+}
+#else
+unsigned long rgCsvLog::now_ms(void) {
+	struct timespec time_now;
+	clock_gettime(CLOCK_MONOTONIC, &time_now);
+	return time_now.tv_sec*1000UL+time_now.tv_nsec/1000000;
+}
+#endif
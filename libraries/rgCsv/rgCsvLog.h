@@ -0,0 +1,93 @@
+/* rgCsvLog.h
+** 2026-10-18 append-only buffered CSV writer
+*/
+
+/* This program is published under the GNU General Public License.
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+#pragma once
+#include <atomic>
+#include <stdarg.h>
+#ifdef ARDUINO
+#include <Arduino.h> // for FreeRTOS
+#endif
+#include "rgCsvStorage.h"
+
+/* Append-only CSV writer for high-rate logging
+   AppendRow() formats a row into the active RAM page and returns at once, it never waits for the file system
+   a page is written to the end of the file when it holds flush_bytes bytes, or when its first row is older than flush_ms ;
+   the rows are then added to the other page while the full page is being written
+   on the ESP32 the pages are written by a low priority task, on a host they are written by AppendRow() and Poll()
+   each page is written then the file is closed : a power loss loses at most the rows of the page being filled
+   when the file would exceed max_file_bytes, it is renamed <path>.1 (the older files become <path>.2 ... <path>.<max_files>)
+   if the rows arrive faster than the file system writes them, the rows are dropped and counted, see GetDropped()
+   Example: log the error counter and the voltage 10 times per second, write every 4 KB or every 5 seconds
+	rgCsvLog Log_obj;
+	Log_obj.Begin("/rxlog.csv", 4096, 4096, 5000, 256*1024, 2);
+	...
+	Log_obj.AppendRow("%lu,%u,%u", millis(), ErrorCounter, millivolts);
+*/
+class rgCsvLog {
+	public:
+		static const int ROW_SIZE=128; // max length of a row, including the final '\n'
+
+	private:
+#ifdef ARDUINO
+		rgCsvLittleFS mDefaultStorage_obj;
+		TaskHandle_t volatile mTask_obj=NULL; // cleared by writer_task() when it stops
+		static void writer_task(void *parameters);
+#else
+		rgCsvPosix mDefaultStorage_obj;
+#endif
+		rgCsvStorage *mStorage_obj=&mDefaultStorage_obj;
+
+		/* All the memory is allocated by Begin() and freed by End(), this block contains:
+			mPages_array[0] and [1]	the two pages of mPageSize_int bytes
+			mPath_str				absolute path of the file
+			mRotatePath_str			2 paths of the rotated files, built by rotate()
+		*/
+		char *mMemory=NULL;
+		char *mPages_array[2]={NULL, NULL};
+		char *mPath_str=NULL;
+		char *mRotatePath_str=NULL;
+		int mPageSize_int=0;
+		int mRotatePathSize_int=0;
+		int mFlushBytes_int=0;
+		unsigned long mFlushMs_lng=0;
+		long mMaxFileBytes_lng=0;
+		int mMaxFiles_int=0;
+
+		// written by the caller of AppendRow() only
+		int mActive_int=0;            // index of the page being filled
+		int mLength_int=0;            // number of bytes in the active page
+		unsigned long mFirstRowMs_lng=0; // time of the first row of the active page
+		// shared with the writer
+		std::atomic<int> mPending_int{-1}; // index of the page waiting to be written, -1=none
+		int mPendingLength_int=0;
+		std::atomic<uint32_t> mDropped_int{0};
+		std::atomic<int> mError_int{0};
+		long mFileBytes_lng=0;        // size of the file, used by the writer only
+		std::atomic<bool> mStop_bool{false};
+
+		bool submit(void);
+		void write_page(void);
+		void rotate(void);
+		static unsigned long now_ms(void);
+
+	public:
+		void SetStorage(rgCsvStorage *storage_obj);
+		int Begin(const char *path_str, int page_size_int, int flush_bytes_int, unsigned long flush_ms_lng,
+			long max_file_bytes_lng=0, int max_files_int=1);
+		int AppendRow(const char *format_str, ...);
+		void Poll(void);
+		int Flush(void);
+		void End(void);
+		uint32_t GetDropped(void) { return mDropped_int; }
+		int GetError(void) { return mError_int; }
+};
@@ -0,0 +1,128 @@
+/* rgCsvStorage.cpp
+** 2026-10-18 storage backends of rgCsv
+** 2026-10-18 append mode, Size()
+*/
+
+/* This program is published under the GNU General Public License.
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+#include "rgCsvStorage.h"
+
+#ifdef ARDUINO
+/* LittleFS backend **********************************************************/
+
+bool rgCsvLittleFS::Mount(void) {
+	return LittleFS.begin(false);
+}
+
+bool rgCsvLittleFS::Exists(const char *path_str) {
+	return LittleFS.exists(path_str);
+}
+
+bool rgCsvLittleFS::Remove(const char *path_str) {
+	return LittleFS.remove(path_str);
+}
+
+// LittleFS replaces an existing file atomically
+bool rgCsvLittleFS::Rename(const char *old_path_str, const char *new_path_str) {
+	return LittleFS.rename(old_path_str, new_path_str);
+}
+
+bool rgCsvLittleFS::Open(const char *path_str, const char *mode_str) {
+	mFile_obj=LittleFS.open(path_str, mode_str);
+	return (bool)mFile_obj;
+}
+
+int rgCsvLittleFS::Read(uint8_t *buffer_out, int size_int) {
+	return mFile_obj.read(buffer_out, size_int);
+}
+
+int rgCsvLittleFS::Write(const uint8_t *buffer, int size_int) {
+	return mFile_obj.write(buffer, size_int);
+}
+
+long rgCsvLittleFS::Size(void) {
+	return mFile_obj.size();
+}
+
+void rgCsvLittleFS::Close(void) {
+	mFile_obj.close();
+}
+
+#else
+/* POSIX backend *************************************************************/
+#include <string.h>
+#include <unistd.h>
+
+// root_str must remain valid while this object is used
+void rgCsvPosix::SetRoot(const char *root_str) {
+	mRoot_str=root_str;
+}
+
+// there is nothing to mount, but the root directory must exist
+bool rgCsvPosix::Mount(void) {
+	return access(mRoot_str, F_OK)==0;
+}
+
+bool rgCsvPosix::Exists(const char *path_str) {
+	return access(full_path(path_str), F_OK)==0;
+}
+
+bool rgCsvPosix::Remove(const char *path_str) {
+	return remove(full_path(path_str))==0;
+}
+
+// rename() replaces an existing file atomically
+bool rgCsvPosix::Rename(const char *old_path_str, const char *new_path_str) {
+	char old_full_path_str[sizeof(mPath_str)];
+	strcpy(old_full_path_str, full_path(old_path_str));
+	return rename(old_full_path_str, full_path(new_path_str))==0;
+}
+
+bool rgCsvPosix::Open(const char *path_str, const char *mode_str) {
+	Close();
+	const char *posix_mode_str="rb";
+	if (strcmp(mode_str, "w")==0)
+		posix_mode_str="wb";
+	else if (strcmp(mode_str, "a")==0)
+		posix_mode_str="ab";
+	mFile_obj=fopen(full_path(path_str), posix_mode_str);
+	return mFile_obj!=NULL;
+}
+
+int rgCsvPosix::Read(uint8_t *buffer_out, int size_int) {
+	size_t count=fread(buffer_out, 1, size_int, mFile_obj);
+	return ferror(mFile_obj) ? -1 : (int)count;
+}
+
+int rgCsvPosix::Write(const uint8_t *buffer, int size_int) {
+	return (int)fwrite(buffer, 1, size_int, mFile_obj);
+}
+
+long rgCsvPosix::Size(void) {
+	long position_lng=ftell(mFile_obj);
+	fseek(mFile_obj, 0, SEEK_END);
+	long retval_lng=ftell(mFile_obj);
+	fseek(mFile_obj, position_lng, SEEK_SET);
+	return retval_lng;
+}
+
+void rgCsvPosix::Close(void) {
+	if (mFile_obj) {
+		fclose(mFile_obj);
+		mFile_obj=NULL;
+	}
+}
+
+// prefix given path with the root directory, the result is valid until the next call
+const char *rgCsvPosix::full_path(const char *path_str) {
+	snprintf(mPath_str, sizeof(mPath_str), "%s/%s", mRoot_str, path_str[0]=='/' ? path_str+1 : path_str);
+	return mPath_str;
+}
+#endif
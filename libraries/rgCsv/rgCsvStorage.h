@@ -0,0 +1,89 @@
+/* rgCsvStorage.h
+** 2026-10-18 storage backends of rgCsv
+** 2026-10-18 append mode, Size()
+*/
+
+/* This program is published under the GNU General Public License.
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+#pragma once
+#include <stdint.h>
+#ifdef ARDUINO
+#include <LittleFS.h>
+#else
+#include <stdio.h>
+#endif
+
+/* Storage backend of rgCsv
+   rgCsv accesses the file system only through this interface, so that the same code runs on the board (LittleFS)
+   and on a Linux host (POSIX files), eg to check the parser against corrupted param files
+   a backend opens one file at a time : each rgCsv object owns its backend, see rgCsv::SetStorage()
+*/
+class rgCsvStorage {
+	public:
+		virtual ~rgCsvStorage() {}
+
+		// mount the file system if it is not already mounted, do not format it ; return value: true=success
+		virtual bool Mount(void)=0;
+		virtual bool Exists(const char *path_str)=0;
+		virtual bool Remove(const char *path_str)=0;
+		// replace the file new_path_str if it exists ; return value: true=success
+		virtual bool Rename(const char *old_path_str, const char *new_path_str)=0;
+
+		// mode_str is "r", "w" or "a" (append) ; return value: true=success
+		virtual bool Open(const char *path_str, const char *mode_str)=0;
+		// return value: number of bytes read or written, 0 on EOF, <0 on error
+		virtual int Read(uint8_t *buffer_out, int size_int)=0;
+		virtual int Write(const uint8_t *buffer, int size_int)=0;
+		// return value: size of the open file in bytes
+		virtual long Size(void)=0;
+		virtual void Close(void)=0;
+};
+
+#ifdef ARDUINO
+// LittleFS file system of the ESP32, the default backend on the board
+class rgCsvLittleFS : public rgCsvStorage {
+	private:
+		File mFile_obj;
+
+	public:
+		bool Mount(void) override;
+		bool Exists(const char *path_str) override;
+		bool Remove(const char *path_str) override;
+		bool Rename(const char *old_path_str, const char *new_path_str) override;
+		bool Open(const char *path_str, const char *mode_str) override;
+		int Read(uint8_t *buffer_out, int size_int) override;
+		int Write(const uint8_t *buffer, int size_int) override;
+		long Size(void) override;
+		void Close(void) override;
+};
+#else
+// POSIX files, the default backend on a host
+// the absolute paths used by rgCsv ("/param.csv") are relative to mRoot_str, the current directory by default
+class rgCsvPosix : public rgCsvStorage {
+	private:
+		FILE *mFile_obj=NULL;
+		const char *mRoot_str=".";
+		char mPath_str[256];
+
+		const char *full_path(const char *path_str);
+
+	public:
+		void SetRoot(const char *root_str);
+		bool Mount(void) override;
+		bool Exists(const char *path_str) override;
+		bool Remove(const char *path_str) override;
+		bool Rename(const char *old_path_str, const char *new_path_str) override;
+		bool Open(const char *path_str, const char *mode_str) override;
+		int Read(uint8_t *buffer_out, int size_int) override;
+		int Write(const uint8_t *buffer, int size_int) override;
+		long Size(void) override;
+		void Close(void) override;
+};
+#endif
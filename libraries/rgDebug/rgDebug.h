@@ -12,10 +12,21 @@
 
 // all debug output is handled by these macros, Serial is never called directly for tracing
 // DEBUG_ON : 0=debug off, 1=output to serial, 2=output to serial and optionally bluetooth with dbtprintln()
+//            3=deferred output to serial : see "Deferred debug output" below
 #ifndef DEBUG_ON
 #define DEBUG_ON 0
 #endif
-#if DEBUG_ON
+#if DEBUG_ON == 3
+#define dbprint(...)    rgLog_Print(__VA_ARGS__)
+#define dbprintln(...)  rgLog_Println(__VA_ARGS__)
+#define dbprintf(...)   rgLog_Printf(__VA_ARGS__)
+#define dbtprintln(...) rgLog_Println(__VA_ARGS__)
+#define dbtprintf(...)  rgLog_Printf(__VA_ARGS__)
+#define setupLog()      rgLog_Begin()
+#define dbflush()       rgLog_Flush()
+#define dbpause()       rgLog_Pause()
+#define dbresume()      rgLog_Resume()
+#elif DEBUG_ON
 #define dbprint(...)   Serial.print(__VA_ARGS__)
 #define dbprintln(...) Serial.println(__VA_ARGS__)
 #define dbprintf(...)  Serial.printf(__VA_ARGS__)
@@ -27,12 +38,209 @@
 #define dbtprintln(...) bt_Writeln(__VA_ARGS__)
 #define dbtprintf(...)  bt_Printf(__VA_ARGS__)
 #endif
+#define setupLog(...)
+#define dbflush()       Serial.flush()
+#define dbpause()       true
+#define dbresume()
 #else
 #define dbprint(...)
 #define dbprintln(...)
 #define dbprintf(...)
 #define dbtprintln(...)
 #define dbtprintf(...)
+#define setupLog(...)
+#define dbflush(...)
+#define dbpause(...)    true
+#define dbresume(...)
+#endif
+
+/* Deferred debug output (DEBUG_ON 3)
+   dbprintf() and friends format their output into a record of a RAM ring and return immediately,
+   a low-priority task started by setupLog() writes the records to Serial while the CPU is idle
+   when the ring is full the record is dropped and counted, the task reports the number of dropped records
+   the ring is shared by all the source files using DEBUG_ON 3, and by all the tasks : it is lock-free
+   dbflush() waits until the ring is empty, call it before a reset
+   dbpause() stops the drain task writing to Serial until dbresume(), eg while sending binary data to Serial ;
+   the records are still queued meanwhile, or dropped when the ring is full
+   dbpause() does not block : it returns false while the drain task is writing, call it again later (always true
+   with the other DEBUG_ON values)
+*/
+#if DEBUG_ON == 3
+#include <Arduino.h>
+#include <atomic>
+#include <stdarg.h>
+#include <type_traits>
+
+#ifndef RGLOG_RECORDS
+#define RGLOG_RECORDS 32      // number of records in the ring, must be a power of 2
+#endif
+#ifndef RGLOG_RECORD_SIZE
+#define RGLOG_RECORD_SIZE 96  // bytes, longer output is truncated but keeps its final '\n'
+#endif
+#define RGLOG_DRAIN_MS 10     // the drain task checks the ring at this interval
+
+struct rgLogRecord {
+    std::atomic<uint32_t> sequence; // see rgLog_claim()
+    uint16_t length;
+    char text[RGLOG_RECORD_SIZE];
+};
+
+struct rgLogRing {
+    rgLogRecord records[RGLOG_RECORDS];
+    std::atomic<uint32_t> head;     // next record to drain
+    std::atomic<uint32_t> tail;     // next record to claim
+    std::atomic<uint32_t> dropped;  // number of records dropped because the ring was full
+    TaskHandle_t task;
+    SemaphoreHandle_t lock;         // held by the drain task while writing to Serial, and by rgLog_Pause()
+};
+
+// zero-initialized before any constructor runs, so it may be used by global objects
+inline rgLogRing rgLog_Ring;
+
+/* Bounded multi-producer queue (D. Vyukov), the sequence of each record tells its state
+   at position pos, the record number idx=pos%RGLOG_RECORDS is free when sequence==pos-idx, and full when sequence==pos-idx+1
+   (the usual algorithm stores pos instead of pos-idx, this offset lets the ring start zero-initialized)
+   Return value: the claimed record, or NULL if the ring is full */
+inline rgLogRecord *rgLog_claim(uint32_t *pos_out) {
+    uint32_t pos=rgLog_Ring.tail.load(std::memory_order_relaxed);
+    while (true) {
+        rgLogRecord *record=&rgLog_Ring.records[pos & (RGLOG_RECORDS-1)];
+        int32_t diff=(int32_t)(record->sequence.load(std::memory_order_acquire)-(pos & ~(RGLOG_RECORDS-1)));
+        if (diff==0) {
+            if (rgLog_Ring.tail.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
+                *pos_out=pos;
+                return record;
+            }
+        }
+        else if (diff<0) {
+            rgLog_Ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return NULL;
+        }
+        else
+            pos=rgLog_Ring.tail.load(std::memory_order_relaxed);
+    }
+}
+
+inline void rgLog_publish(rgLogRecord *record, uint32_t pos) {
+    record->sequence.store((pos & ~(RGLOG_RECORDS-1))+1, std::memory_order_release);
+}
+
+// newline : the output ends with '\n', which is kept when the output is truncated, or the lines would run together
+inline void rgLog_vformat(bool newline, const char *format, va_list args) {
+    uint32_t pos;
+    rgLogRecord *record=rgLog_claim(&pos);
+    if (record) {
+        int length=vsnprintf(record->text, RGLOG_RECORD_SIZE, format, args);
+        if (length>=RGLOG_RECORD_SIZE && newline)
+            record->text[RGLOG_RECORD_SIZE-2]='\n';
+        record->length=length<0 ? 0 : min(length, RGLOG_RECORD_SIZE-1);
+        rgLog_publish(record, pos);
+    }
+}
+
+inline void rgLog_Format(bool newline, const char *format, ...) __attribute__((format(printf, 2, 3)));
+inline void rgLog_Format(bool newline, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    rgLog_vformat(newline, format, args);
+    va_end(args);
+}
+
+inline void rgLog_Printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+inline void rgLog_Printf(const char *format, ...) {
+    size_t length=strlen(format);
+    va_list args;
+    va_start(args, format);
+    rgLog_vformat(length && format[length-1]=='\n', format, args);
+    va_end(args);
+}
+
+inline void rgLog_Print(const char *text) { rgLog_Printf("%s", text); }
+inline void rgLog_Print(char value) { rgLog_Printf("%c", value); }
+inline void rgLog_Print(const String &text) { rgLog_Printf("%s", text.c_str()); }
+
+inline void rgLog_Println(void) { rgLog_Print('\n'); }
+inline void rgLog_Println(const char *text) { rgLog_Printf("%s\n", text); }
+inline void rgLog_Println(const String &text) { rgLog_Printf("%s\n", text.c_str()); }
+
+// numbers are formatted directly into the record, as Serial.print() does : integers in decimal, floats with 2 decimals
+// other types are converted with String(), which allocates
+template <typename T> inline void rgLog_Print(T value, const char *end="") {
+    bool newline=(*end!='\0' && end[strlen(end)-1]=='\n');
+    if constexpr (std::is_convertible<T, const char *>::value)
+        rgLog_Format(newline, "%s%s", (const char *)value, end);
+    else if constexpr (std::is_floating_point<T>::value)
+        rgLog_Format(newline, "%.2f%s", (double)value, end);
+    else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value)
+        rgLog_Format(newline, "%lld%s", (long long)value, end);
+    else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value)
+        rgLog_Format(newline, "%llu%s", (unsigned long long)value, end);
+    else
+        rgLog_Format(newline, "%s%s", String(value).c_str(), end);
+}
+template <typename T> inline void rgLog_Println(T value) { rgLog_Print(value, "\n"); }
+
+// single consumer : called only by rgLog_task()
+// Return value: true=one record written to Serial, false=ring empty
+inline bool rgLog_drain(void) {
+    uint32_t pos=rgLog_Ring.head.load(std::memory_order_relaxed);
+    rgLogRecord *record=&rgLog_Ring.records[pos & (RGLOG_RECORDS-1)];
+    int32_t diff=(int32_t)(record->sequence.load(std::memory_order_acquire)-((pos & ~(RGLOG_RECORDS-1))+1));
+    if (diff<0)
+        return false;
+    Serial.write(record->text, record->length);
+    rgLog_Ring.head.store(pos+1, std::memory_order_relaxed);
+    record->sequence.store((pos & ~(RGLOG_RECORDS-1))+RGLOG_RECORDS, std::memory_order_release);
+    return true;
+}
+
+inline void rgLog_task(void *parameters) {
+    uint32_t reported=0; // number of dropped records already reported
+    while (true) {
+        xSemaphoreTake(rgLog_Ring.lock, portMAX_DELAY);
+        while (rgLog_drain())
+            ;
+        uint32_t dropped=rgLog_Ring.dropped.load(std::memory_order_relaxed);
+        if (dropped!=reported) {
+            Serial.printf("*** %lu log records dropped\n", (unsigned long)(dropped-reported));
+            reported=dropped;
+        }
+        xSemaphoreGive(rgLog_Ring.lock);
+        vTaskDelay(pdMS_TO_TICKS(RGLOG_DRAIN_MS));
+    }
+}
+
+// start the drain task at idle priority, on whichever core is idle
+inline void rgLog_Begin(void) {
+    if (rgLog_Ring.task==NULL) {
+        rgLog_Ring.lock=xSemaphoreCreateMutex();
+        xTaskCreate(rgLog_task, "rgLog", 3072, NULL, tskIDLE_PRIORITY, &rgLog_Ring.task);
+    }
+}
+
+// stop writing to Serial : keep the drain task waiting once it has written its current records
+// Return value: true=paused until rgLog_Resume(), false=the drain task is writing, try again later
+inline bool rgLog_Pause(void) {
+    if (rgLog_Ring.lock)
+        return xSemaphoreTake(rgLog_Ring.lock, 0)==pdTRUE;
+    return true;
+}
+
+// let the drain task write the queued records
+inline void rgLog_Resume(void) {
+    if (rgLog_Ring.lock)
+        xSemaphoreGive(rgLog_Ring.lock);
+}
+
+// wait until the ring is empty, or 1 second if the drain task is not running
+inline void rgLog_Flush(void) {
+    for (uint8_t idx=0; idx<100; idx++) {
+        if (rgLog_Ring.head.load(std::memory_order_relaxed)==rgLog_Ring.tail.load(std::memory_order_relaxed))
+            break;
+        vTaskDelay(pdMS_TO_TICKS(RGLOG_DRAIN_MS));
+    }
+    Serial.flush();
+}
 #endif
 
 // all trace output is handled by these macros, Serial is never called directly for tracing
@@ -60,3 +268,130 @@
 #define trbtprintf(...)
 #endif
 
+
+/* Profiling sections, based on the CPU cycle counter
+   PROFILE_ON : 0=profiling off, the macros compile to nothing, 1=profiling on
+   profileSection("name") measures the time spent from this line to the end of the enclosing block,
+   profileCall("name", expression) measures the evaluation of expression and returns its value,
+   each named section aggregates count, min, avg, max and p99 of its measures
+   profileReport(period_ms) prints a summary of all the sections every period_ms with dbprintf() and resets them,
+   call it in loop() ; all the source files using PROFILE_ON 1 share the same list of sections
+   p99 is approximate (within 25%), it is taken from a histogram with 4 buckets per power of 2
+   a section must be measured and reported by tasks running on the same core, or the measures of an ongoing
+   period may be slightly off
+*/
+#ifndef PROFILE_ON
+#define PROFILE_ON 0
+#endif
+#if PROFILE_ON
+#include <Arduino.h>
+#include <atomic>
+
+#define RGPROFILE_BUCKETS 128 // 4 buckets per power of 2 for 32 bits
+
+struct rgProfileSection;
+inline std::atomic<rgProfileSection *> rgProfile_Sections{NULL}; // list of all the sections
+
+struct rgProfileSection {
+    const char *name;
+    rgProfileSection *next;
+    uint32_t count;
+    uint32_t lowest;
+    uint32_t highest;
+    uint64_t total;
+    uint16_t histogram[RGPROFILE_BUCKETS];
+
+    rgProfileSection(const char *section_name) : name(section_name) {
+        Reset();
+        next=rgProfile_Sections.load(std::memory_order_relaxed);
+        while (!rgProfile_Sections.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed))
+            ;
+    }
+
+    void Reset(void) {
+        count=0;
+        lowest=UINT32_MAX;
+        highest=0;
+        total=0;
+        memset(histogram, 0, sizeof(histogram));
+    }
+
+    // bucket of the given number of cycles : 2 bits of exponent per octave
+    static uint8_t bucket(uint32_t cycles) {
+        if (cycles<4)
+            return cycles;
+        uint8_t octave=31-__builtin_clz(cycles);
+        return octave*4+((cycles>>(octave-2)) & 3);
+    }
+
+    // highest number of cycles falling into the given bucket
+    static uint32_t bucket_limit(uint8_t index) {
+        if (index<4)
+            return index;
+        uint8_t octave=index/4;
+        return (uint32_t)((((uint64_t)4+index%4+1)<<(octave-2))-1);
+    }
+
+    void Add(uint32_t cycles) {
+        count++;
+        total+=cycles;
+        if (cycles<lowest)
+            lowest=cycles;
+        if (cycles>highest)
+            highest=cycles;
+        uint16_t *counter=&histogram[bucket(cycles)];
+        if (*counter<UINT16_MAX)
+            (*counter)++;
+    }
+
+    uint32_t P99(void) {
+        uint32_t remaining=count-count*99/100; // number of measures above p99
+        for (int16_t index=RGPROFILE_BUCKETS-1; index>=0; index--) {
+            if (histogram[index]>=remaining)
+                return bucket_limit(index)<highest ? bucket_limit(index) : highest;
+            remaining-=histogram[index];
+        }
+        return highest;
+    }
+};
+
+// measures the time spent in its scope
+struct rgProfileTimer {
+    rgProfileSection &section;
+    uint32_t start;
+    rgProfileTimer(rgProfileSection &timed_section) : section(timed_section), start(ESP.getCycleCount()) {}
+    ~rgProfileTimer() { section.Add(ESP.getCycleCount()-start); }
+};
+
+inline void rgProfile_Report(unsigned long period_ms, void (*print)(const char *line)) {
+    static unsigned long Last_time=0; // ms
+    unsigned long time_now=millis();
+    if (time_now-Last_time<period_ms)
+        return;
+    Last_time=time_now;
+    uint32_t mhz=getCpuFrequencyMhz();
+    char line[80];
+    snprintf(line, sizeof(line), "%-16s %6s %9s %9s %9s %9s\n", "section", "count", "min", "avg", "max", "p99 (µs)");
+    print(line);
+    for (rgProfileSection *section=rgProfile_Sections.load(std::memory_order_acquire); section; section=section->next) {
+        if (section->count) {
+            snprintf(line, sizeof(line), "%-16.16s %6lu %9.1f %9.1f %9.1f %9.1f\n", section->name, (unsigned long)section->count,
+                (float)section->lowest/mhz, (float)section->total/section->count/mhz, (float)section->highest/mhz, (float)section->P99()/mhz);
+            print(line);
+            section->Reset();
+        }
+    }
+}
+
+#define RGPROFILE_CONCAT2(a, b) a##b
+#define RGPROFILE_CONCAT(a, b) RGPROFILE_CONCAT2(a, b)
+#define profileSection(name) \
+    static rgProfileSection RGPROFILE_CONCAT(rgProfile_section_, __LINE__)(name); \
+    rgProfileTimer RGPROFILE_CONCAT(rgProfile_timer_, __LINE__)(RGPROFILE_CONCAT(rgProfile_section_, __LINE__))
+#define profileCall(name, expression) ([&]() { profileSection(name); return expression; }())
+#define profileReport(period_ms) rgProfile_Report(period_ms, [](const char *line) { dbprintf("%s", line); })
+#else
+#define profileSection(...)
+#define profileCall(name, expression) (expression)
+#define profileReport(...)
+#endif
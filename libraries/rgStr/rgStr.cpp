@@ -1,6 +1,8 @@
 /* rgStr.cpp - Library
 ** 2022-11-07 derived from arduinotx project
 ** 2024-07-21 some renaming, better implementation of TrimWhitespace(), new TrimCommentAndWhitespace()
+** 2026-10-18 standard C functions only, builds on a host, TrimWhitespace() moves the characters with memmove()
+** 2026-10-18 TrimWhitespace() in a single pass, Hex2Dec() with shifts, parsing toolkit
 */
 
 #include "rgStr.h"
@@ -13,7 +15,7 @@ short Isblank(const char *line_str) {
 	short retval_byt = 1;
 	const char *c_ptr = line_str;
 	while (*c_ptr && retval_byt) {
-		if (isSpace(*c_ptr))
+		if (isspace((unsigned char)*c_ptr))
 			c_ptr++;
 		else
 			retval_byt = 0;
@@ -28,18 +30,22 @@ char *TrimCommentAndWhitespace(char *line_out) {
 	return TrimWhitespace(line_out);
 }
 
+// Same as TrimCommentAndWhitespace() without moving the characters : the comment and the trailing white-space
+// are cut by a '\0', and the return value points to the first non-blank character of line_str
+char *SkipCommentAndWhitespace(char *line_str) {
+	char *ptr=strchr(line_str, '#');
+	if (ptr)
+		*ptr='\0';
+	StrSpan span=TrimSpan(MakeSpan(line_str));
+	char *retval_str=line_str+(span.ptr-line_str);
+	retval_str[span.len]='\0';
+	return retval_str;
+}
+
 char *TrimWhitespace(char *line_out) {
-	char *ptr = line_out;
-	while (isspace(*ptr))
-		ptr++;
-	if (*ptr) {
-		char *last_chr = ptr + strlen(ptr) - 1;
-		while (last_chr > ptr && isspace(*last_chr))
-			last_chr--;
-		*(last_chr+1) = 0;
-	}
-	if (ptr!=line_out)
-		memcpy(line_out, ptr, strlen(ptr)+1);
+	StrSpan span=TrimSpan(MakeSpan(line_out));
+	memmove(line_out, span.ptr, span.len); // the ranges may overlap
+	line_out[span.len]='\0';
 	return line_out;
 }
 
@@ -61,7 +67,7 @@ unsigned long Hex2Dec(char *hex_str, short length_byt) {
 	for (short idx_byt=0; idx_byt<length_byt; idx_byt++) {
 		char x_chr = toupper(hex_str[idx_byt]);
 		if (ishexdigit(x_chr))
-			retval_lng += (x_chr - ( x_chr <= '9' ? '0':'7')) * (1<<(4*(length_byt-1-idx_byt)));
+			retval_lng |= (unsigned long)(x_chr - ( x_chr <= '9' ? '0':'7')) << (4*(length_byt-1-idx_byt));
 		else
 			break;
 	}
@@ -81,6 +87,112 @@ char *BinStr(char *buffer_str, int nbits_int, unsigned int num_int) {
     return buffer_str;
 }
 
+/* Parsing toolkit ***********************************************************/
+
+StrSpan MakeSpan(const char *str) {
+	StrSpan retval={str, strlen(str)};
+	return retval;
+}
+
+// return the span without its leading and trailing white-space characters, the characters are not moved
+StrSpan TrimSpan(StrSpan span) {
+	const char *first_ptr=span.ptr;
+	const char *end_ptr=span.ptr+span.len;
+	while (first_ptr<end_ptr && isspace((unsigned char)*first_ptr))
+		first_ptr++;
+	while (end_ptr>first_ptr && isspace((unsigned char)*(end_ptr-1)))
+		end_ptr--;
+	StrSpan retval={first_ptr, (size_t)(end_ptr-first_ptr)};
+	return retval;
+}
+
+// Parse an optional sign followed by decimal digits at the beginning of given span, in a single pass
+// value_out is set only if the return value is STR_PARSE_OK
+// used_out optional, receives the number of characters used, 0 if no digit was found
+// return value: STR_PARSE_OK, STR_PARSE_EMPTY or STR_PARSE_RANGE
+int ParseInt(StrSpan span, int32_t min_value, int32_t max_value, int32_t *value_out, size_t *used_out) {
+	size_t idx=0;
+	bool negative=false;
+	if (span.len && (span.ptr[0]=='-' || span.ptr[0]=='+')) {
+		negative=(span.ptr[0]=='-');
+		idx++;
+	}
+	size_t first_digit=idx;
+	// accumulate the magnitude as unsigned, and stop accumulating once it exceeds the largest int32_t magnitude
+	const uint32_t limit=negative ? 2147483648UL : 2147483647UL;
+	uint32_t magnitude=0;
+	bool overflow=false;
+	for (; idx<span.len && span.ptr[idx]>='0' && span.ptr[idx]<='9'; idx++) {
+		uint32_t digit=span.ptr[idx]-'0';
+		if (!overflow && magnitude>(limit-digit)/10)
+			overflow=true;
+		if (!overflow)
+			magnitude=magnitude*10+digit;
+	}
+	if (idx==first_digit) {
+		if (used_out)
+			*used_out=0;
+		return STR_PARSE_EMPTY;
+	}
+	if (used_out)
+		*used_out=idx;
+	if (overflow)
+		return STR_PARSE_RANGE;
+	int32_t value=negative ? (int32_t)(0-magnitude) : (int32_t)magnitude;
+	if (value<min_value || value>max_value)
+		return STR_PARSE_RANGE;
+	*value_out=value;
+	return STR_PARSE_OK;
+}
+
+// Parse hexadecimal digits at the beginning of given span, an optional "0x" prefix is skipped
+// same conventions as ParseInt()
+int ParseHex(StrSpan span, uint32_t max_value, uint32_t *value_out, size_t *used_out) {
+	size_t idx=0;
+	if (span.len>2 && span.ptr[0]=='0' && (span.ptr[1]=='x' || span.ptr[1]=='X') && ishexdigit(span.ptr[2]))
+		idx=2;
+	size_t first_digit=idx;
+	uint32_t value=0;
+	bool overflow=false;
+	for (; idx<span.len && ishexdigit(span.ptr[idx]); idx++) {
+		char x_chr=span.ptr[idx];
+		uint32_t digit=x_chr<='9' ? x_chr-'0' : (x_chr|0x20)-'a'+10; // |0x20 converts to lower case
+		if (value>>28)
+			overflow=true; // the next shift would lose bits
+		value=(value<<4)|digit;
+	}
+	if (idx==first_digit) {
+		if (used_out)
+			*used_out=0;
+		return STR_PARSE_EMPTY;
+	}
+	if (used_out)
+		*used_out=idx;
+	if (overflow || value>max_value)
+		return STR_PARSE_RANGE;
+	*value_out=value;
+	return STR_PARSE_OK;
+}
+
+// Format given value in decimal into given buffer, without printf()
+// return value: number of characters written, not counting the final '\0'
+int FormatInt(int32_t value, char *buffer_out) {
+	char digits[FORMATINT_SIZE];
+	int count=0;
+	uint32_t magnitude=value<0 ? 0-(uint32_t)value : (uint32_t)value;
+	do {
+		digits[count++]='0'+magnitude%10;
+		magnitude/=10;
+	} while (magnitude);
+	int length=0;
+	if (value<0)
+		buffer_out[length++]='-';
+	while (count)
+		buffer_out[length++]=digits[--count];
+	buffer_out[length]='\0';
+	return length;
+}
+
 static short ishexdigit(char a_chr) {
 	return (a_chr >= '0' && a_chr <= '9') || (a_chr >= 'A' && a_chr <= 'F') || (a_chr >= 'a' && a_chr <= 'f');;
 }
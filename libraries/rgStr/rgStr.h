@@ -1,16 +1,50 @@
 /* rgStr.h - Library
 ** 2022-11-07 derived from arduinotx project
+** 2026-10-18 builds on a host without Arduino.h
+** 2026-10-18 non-allocating parsing toolkit: StrSpan, TrimSpan(), ParseInt(), ParseHex(), FormatInt()
 */
 #pragma once
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#else
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
 
 #define STRLIB_NAME	"rgStr" // spaces not permitted
-#define STRLIB_VERSION	"v1.0.0"
+#define STRLIB_VERSION	"v1.2.0"
 
 short Isblank(const char *line_str);
 char *TrimCommentAndWhitespace(char *out_line_str);
 char *TrimWhitespace(char *out_line_str);
+char *SkipCommentAndWhitespace(char *line_str);
 char *TimeString(unsigned long seconds_lng, char *out_buffer_str);
 unsigned long Hex2Dec(char *hex_str, short length_byt);
 char *BinStr(char *buffer_str, int nbits_int, unsigned int num_int);
+
+/* Non-allocating parsing toolkit
+   a StrSpan designates len characters starting at ptr, inside a string that is not modified nor copied
+   the parsers read the characters of the span only, they do not need a final '\0', and they report
+   the number of characters used : the caller can check that the whole span was parsed, or continue after the number
+*/
+struct StrSpan {
+	const char *ptr;
+	size_t len;
+};
+
+// return values of ParseInt() and ParseHex()
+#define STR_PARSE_OK		0
+#define STR_PARSE_EMPTY		-1 // no digit found
+#define STR_PARSE_RANGE		-2 // the number is out of range (the digits are consumed nevertheless)
+
+StrSpan MakeSpan(const char *str);
+StrSpan TrimSpan(StrSpan span);
+int ParseInt(StrSpan span, int32_t min_value, int32_t max_value, int32_t *value_out, size_t *used_out=NULL);
+int ParseHex(StrSpan span, uint32_t max_value, uint32_t *value_out, size_t *used_out=NULL);
+// buffer_out must hold at least FORMATINT_SIZE chars
+#define FORMATINT_SIZE 12 // "-2147483648"
+int FormatInt(int32_t value, char *buffer_out);
@@ -0,0 +1,213 @@
+/* This program is published under the GNU General Public License.
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/* Host-side benchmark of rgCsv : Load(), Save(), keyed lookups and the rgCsvRows iterator, with the rgCsvPosix backend
+
+   Build: g++ -std=c++17 -O2 -I../libraries/rgCsv -I../libraries/rgStr -o csvbench csvbench.cpp \
+              ../libraries/rgCsv/rgCsv.cpp ../libraries/rgCsv/rgCsvStorage.cpp ../libraries/rgStr/rgStr.cpp
+
+   Usage: csvbench [-n iterations] [-d directory]
+       -n number of Load() and Save() of each file, default 2000
+       -d directory of the test files, default /tmp ; use a tmpfs to measure the parser rather than the disk
+   Files:
+       param.csv   keyed, PARAM_LINES lines "KEYnnn,value", like the param files of Tx and Rx
+       table.csv   positional, TABLE_LINES lines of TABLE_CELLS integer and string cells
+       rows.csv    ROWS_LINES lines read by rgCsvRows, like the lookup tables too large to be loaded
+   the timings of the host are much shorter than on the board, compare the results of 2 versions of rgCsv
+   on the same host rather than the absolute values
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include "rgCsv.h"
+
+const int PARAM_LINES=64;
+const int PARAM_CELLEN=12;
+const int TABLE_LINES=100;
+const int TABLE_CELLS=8;
+const int TABLE_CELLEN=11; // "-2147483648"
+const int ROWS_LINES=10000;
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+static long write_file(const char *directory, const char *name, const std::string &content) {
+    std::string path=std::string(directory)+"/"+name;
+    FILE *file=fopen(path.c_str(), "w");
+    if (file==NULL || fwrite(content.data(), 1, content.size(), file)!=content.size()) {
+        fprintf(stderr, "Error: cannot write %s\n", path.c_str());
+        exit(1);
+    }
+    fclose(file);
+    return content.size();
+}
+
+static void print_result(const char *name, int count, double seconds, long lines, long bytes) {
+    printf("%-24s %10.1f us/call %12.0f lines/s %8.1f MB/s\n", name, seconds*1e6/count,
+        lines*count/seconds, bytes*count/seconds/1e6);
+}
+
+static void bench_param(const char *directory, int iterations) {
+    std::string content="# Application parameters\n";
+    char line_str[64];
+    for (int idx=0; idx<PARAM_LINES; idx++) {
+        snprintf(line_str, sizeof(line_str), "KEY%03d,%d\n", idx, idx*1021);
+        content+=line_str;
+    }
+    long bytes=write_file(directory, "param.csv", content);
+
+    rgCsvPosix storage_obj;
+    storage_obj.SetRoot(directory);
+    rgCsv csv_obj;
+    csv_obj.SetStorage(&storage_obj);
+    if (csv_obj.Allocate("/param.csv", PARAM_LINES, 2, PARAM_CELLEN, false, true)!=0) {
+        fprintf(stderr, "Error: Allocate() failed\n");
+        exit(1);
+    }
+    auto start=std::chrono::steady_clock::now();
+    for (int idx=0; idx<iterations; idx++)
+        if (csv_obj.Load()!=PARAM_LINES) {
+            fprintf(stderr, "Error: Load() failed\n");
+            exit(1);
+        }
+    print_result("param.csv Load()", iterations, seconds_since(start), PARAM_LINES, bytes);
+
+    const int LOOKUPS=iterations*PARAM_LINES;
+    int32_t sum=0;
+    start=std::chrono::steady_clock::now();
+    for (int idx=0; idx<LOOKUPS; idx++) {
+        snprintf(line_str, sizeof(line_str), "KEY%03d", idx%PARAM_LINES);
+        sum+=csv_obj.GetInt(line_str);
+    }
+    double seconds=seconds_since(start);
+    printf("%-24s %10.3f us/call (checksum %d)\n", "param.csv GetInt()", seconds*1e6/LOOKUPS, sum);
+
+    // Save() writes the file only if a cell has changed
+    start=std::chrono::steady_clock::now();
+    for (int idx=0; idx<iterations; idx++) {
+        csv_obj.SetInt("KEY000", idx);
+        if (csv_obj.Save()!=PARAM_LINES) {
+            fprintf(stderr, "Error: Save() failed\n");
+            exit(1);
+        }
+    }
+    print_result("param.csv Save()", iterations, seconds_since(start), PARAM_LINES, bytes);
+    csv_obj.Release();
+}
+
+static void bench_table(const char *directory, int iterations) {
+    std::string content;
+    char cell_str[32];
+    for (int line=0; line<TABLE_LINES; line++) {
+        for (int column=0; column<TABLE_CELLS; column++) {
+            if (column%2)
+                snprintf(cell_str, sizeof(cell_str), "%s%d", column ? "," : "", -line*column*100003);
+            else
+                snprintf(cell_str, sizeof(cell_str), "%s cell%d ", column ? "," : "", line);
+            content+=cell_str;
+        }
+        content+="\n";
+    }
+    long bytes=write_file(directory, "table.csv", content);
+
+    rgCsvPosix storage_obj;
+    storage_obj.SetRoot(directory);
+    rgCsv csv_obj;
+    csv_obj.SetStorage(&storage_obj);
+    if (csv_obj.Allocate("/table.csv", TABLE_LINES, TABLE_CELLS, TABLE_CELLEN, false)!=0) {
+        fprintf(stderr, "Error: Allocate() failed\n");
+        exit(1);
+    }
+    auto start=std::chrono::steady_clock::now();
+    for (int idx=0; idx<iterations; idx++)
+        if (csv_obj.Load()!=TABLE_LINES) {
+            fprintf(stderr, "Error: Load() failed\n");
+            exit(1);
+        }
+    print_result("table.csv Load()", iterations, seconds_since(start), TABLE_LINES, bytes);
+
+    start=std::chrono::steady_clock::now();
+    for (int idx=0; idx<iterations; idx++) {
+        csv_obj.SetIntCell(idx%TABLE_LINES, 1, -idx);
+        if (csv_obj.Save(TABLE_LINES)!=TABLE_LINES) {
+            fprintf(stderr, "Error: Save() failed\n");
+            exit(1);
+        }
+    }
+    print_result("table.csv Save()", iterations, seconds_since(start), TABLE_LINES, bytes);
+    csv_obj.Release();
+}
+
+static void bench_rows(const char *directory, int iterations) {
+    std::string content="# lookup table\n";
+    char line_str[64];
+    for (int idx=0; idx<ROWS_LINES; idx++) {
+        snprintf(line_str, sizeof(line_str), "%d, %d.%03d\n", idx, idx/7, idx%1000);
+        content+=line_str;
+    }
+    long bytes=write_file(directory, "rows.csv", content);
+
+    rgCsvPosix storage_obj;
+    storage_obj.SetRoot(directory);
+    rgCsvRows rows_obj;
+    rows_obj.SetStorage(&storage_obj);
+    int count=iterations/100>0 ? iterations/100 : 1;
+    double sum=0;
+    auto start=std::chrono::steady_clock::now();
+    for (int idx=0; idx<count; idx++) {
+        if (rows_obj.Open("/rows.csv")!=0) {
+            fprintf(stderr, "Error: Open() failed\n");
+            exit(1);
+        }
+        int lines=0;
+        while (rows_obj.Next()>0) {
+            sum+=rows_obj.GetInt(0, 0)+rows_obj.GetFloat(1, 0.0);
+            lines++;
+        }
+        rows_obj.Close();
+        if (lines!=ROWS_LINES) {
+            fprintf(stderr, "Error: Next() failed at line %d\n", lines+1);
+            exit(1);
+        }
+    }
+    print_result("rows.csv rgCsvRows", count, seconds_since(start), ROWS_LINES, bytes);
+    printf("%-24s (checksum %.0f)\n", "", sum);
+}
+
+int main(int argc, char *argv[]) {
+    int iterations=2000;
+    const char *directory="/tmp";
+    for (int idx=1; idx<argc; idx++) {
+        if (strcmp(argv[idx], "-n")==0 && idx+1<argc)
+            iterations=atoi(argv[++idx]);
+        else if (strcmp(argv[idx], "-d")==0 && idx+1<argc)
+            directory=argv[++idx];
+        else {
+            fprintf(stderr, "Usage: %s [-n iterations] [-d directory]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (iterations<1 || access(directory, W_OK)!=0) {
+        fprintf(stderr, "Error: iterations must be positive and %s must be writable\n", directory);
+        return 1;
+    }
+    printf("%s %s, %d iterations in %s\n", CSVLIB_NAME, CSVLIB_VERSION, iterations, directory);
+    bench_param(directory, iterations);
+    bench_table(directory, iterations);
+    bench_rows(directory, iterations);
+    for (const char *name : {"param.csv", "table.csv", "rows.csv"})
+        unlink((std::string(directory)+"/"+name).c_str());
+    return 0;
+}
@@ -0,0 +1,316 @@
+/* This program is published under the GNU General Public License.
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/* Host-side fuzzer of the rgCsv parser : rgCsvReader::ReadLine(), rgCsv::parse() through Load(), rgCsvRows::Next(),
+   the keyed mode and Save(), with the rgCsvPosix backend
+
+   Build: g++ -std=c++17 -g -O1 -fsanitize=address,undefined -I../libraries/rgCsv -I../libraries/rgStr -o csvfuzz csvfuzz.cpp \
+              ../libraries/rgCsv/rgCsv.cpp ../libraries/rgCsv/rgCsvStorage.cpp ../libraries/rgStr/rgStr.cpp
+   or with libFuzzer: clang++ -std=c++17 -g -O1 -fsanitize=fuzzer,address,undefined -DCSVFUZZ_LIBFUZZER ...same files...
+
+   Usage: ASAN_OPTIONS=detect_leaks=0 csvfuzz [-n iterations] [-s seed] [file.csv...]
+       without file : mutates the built-in seed files for n iterations, default 100000
+       with files : runs each file once, eg to replay a crash
+   each input is written to fuzz.csv in a temporary directory ; on a failed check the input is saved to
+   crash-<iteration>.csv in the current directory and the program aborts
+   the cells are at most MAXCELLEN characters, less than the width of a 32-bit integer, so that the
+   integer formatting bounds of SetIntCell() and Save() are exercised too
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "rgCsv.h"
+
+const int MAXLINES=6;
+const int MAXCELLS=4;
+const int MAXCELLEN=4; // "-2147483648" takes 11 characters
+const int READER_BUFFER_SIZE=17;
+const char FILE_NAME[]="/fuzz.csv";
+
+static char Root_str[]="/tmp/csvfuzz-XXXXXX";
+static std::string Input; // the current input, saved on failure
+static unsigned long Iteration=0;
+
+static void failure(const char *check_str, int value) {
+    fprintf(stderr, "csvfuzz: check failed at iteration %lu: %s (%d)\n", Iteration, check_str, value);
+    char name_str[32];
+    snprintf(name_str, sizeof(name_str), "crash-%lu.csv", Iteration);
+    std::ofstream(name_str, std::ios::binary).write(Input.data(), Input.size());
+    fprintf(stderr, "csvfuzz: input saved to %s\n", name_str);
+    abort();
+}
+
+#define CHECK(condition, value) do { if (!(condition)) failure(#condition, (value)); } while (0)
+
+static void write_input(const uint8_t *data, size_t size) {
+    Input.assign((const char *)data, size);
+    std::string path=std::string(Root_str)+FILE_NAME;
+    std::ofstream(path, std::ios::binary|std::ios::trunc).write(Input.data(), Input.size());
+}
+
+static void fuzz_reader(void) {
+    rgCsvPosix storage_obj;
+    storage_obj.SetRoot(Root_str);
+    CHECK(storage_obj.Open(FILE_NAME, "r"), 0);
+    rgCsvReader reader_obj;
+    reader_obj.Begin(&storage_obj);
+    char buffer_str[READER_BUFFER_SIZE+1];
+    buffer_str[READER_BUFFER_SIZE]='#'; // guard byte
+    size_t lines=0;
+    while (true) {
+        int length_int=reader_obj.ReadLine(buffer_str, READER_BUFFER_SIZE);
+        CHECK(buffer_str[READER_BUFFER_SIZE]=='#', length_int);
+        if (length_int<0) {
+            CHECK(length_int==-1 || length_int==-2, length_int);
+            if (length_int==-2)
+                CHECK(buffer_str[0]=='\0', length_int);
+            break; // -1 ends the reading too, see Load()
+        }
+        else
+            CHECK(length_int<READER_BUFFER_SIZE && (int)strlen(buffer_str)<=length_int, length_int); // < if the line contains a '\0'
+        CHECK(++lines<=Input.size()+1, (int)lines);
+    }
+    storage_obj.Close();
+}
+
+// check every cell of a loaded file, return the number of cells containing a value
+static int check_cells(rgCsv *csv_obj, int lines_int) {
+    int values_int=0;
+    for (int line_int=0; line_int<MAXLINES; line_int++)
+        for (int column_int=0; column_int<MAXCELLS; column_int++) {
+            const char *value_str=csv_obj->GetStrCell(line_int, column_int);
+            if (value_str) {
+                CHECK(strlen(value_str)<=MAXCELLEN && *value_str && line_int<lines_int, line_int);
+                values_int++;
+            }
+            else if (csv_obj->GetIntCell(line_int, column_int))
+                values_int++;
+            csv_obj->GetFloatCell(line_int, column_int);
+        }
+    CHECK(csv_obj->GetStrCell(MAXLINES, 0)==NULL && csv_obj->GetIntCell(0, MAXCELLS)==-1, 0);
+    return values_int;
+}
+
+static void fuzz_positional(void) {
+    rgCsvPosix storage_obj;
+    storage_obj.SetRoot(Root_str);
+    rgCsv csv_obj;
+    csv_obj.SetStorage(&storage_obj);
+    CHECK(csv_obj.Allocate(FILE_NAME, MAXLINES, MAXCELLS, MAXCELLEN, false)==0, 0);
+    int lines_int=csv_obj.Load();
+    CHECK(lines_int>=-6 && lines_int<=MAXLINES, lines_int);
+    if (lines_int>0) {
+        check_cells(&csv_obj, lines_int);
+        // every value wider than MAXCELLEN must be refused
+        CHECK(csv_obj.SetIntCell(0, 0, INT32_MIN)==-2, 0);
+        CHECK(csv_obj.SetIntCell(0, 0, 100000)==-2, 0);
+        CHECK(csv_obj.SetStrCell(0, 0, "12345")==-2, 0);
+        CHECK(csv_obj.SetIntCell(0, 0, -999)==0, 0);
+        CHECK(csv_obj.SetIntCell(MAXLINES, 0, 1)==-1, 0);
+        CHECK(csv_obj.IsDirty(), 0);
+        int result_int=csv_obj.Save(lines_int);
+        CHECK(result_int==lines_int, result_int);
+        // the file written by Save() must be loaded again with the same values
+        std::vector<int32_t> int_values;
+        std::vector<std::string> str_values;
+        for (int line_int=0; line_int<lines_int; line_int++)
+            for (int column_int=0; column_int<MAXCELLS; column_int++) {
+                const char *value_str=csv_obj.GetStrCell(line_int, column_int);
+                str_values.push_back(value_str ? value_str : "");
+                int_values.push_back(value_str ? 0 : csv_obj.GetIntCell(line_int, column_int));
+            }
+        result_int=csv_obj.Load();
+        CHECK(result_int==lines_int, result_int);
+        CHECK(csv_obj.GetIntCell(0, 0)==-999, csv_obj.GetIntCell(0, 0));
+        for (int line_int=0, idx=0; line_int<lines_int; line_int++)
+            for (int column_int=0; column_int<MAXCELLS; column_int++, idx++) {
+                const char *value_str=csv_obj.GetStrCell(line_int, column_int);
+                CHECK(str_values[idx]==(value_str ? value_str : ""), idx);
+                CHECK(int_values[idx]==(value_str ? 0 : csv_obj.GetIntCell(line_int, column_int)), idx);
+            }
+    }
+    csv_obj.Release();
+}
+
+static void fuzz_keyed(void) {
+    rgCsvPosix storage_obj;
+    storage_obj.SetRoot(Root_str);
+    rgCsv csv_obj;
+    csv_obj.SetStorage(&storage_obj);
+    CHECK(csv_obj.Allocate(FILE_NAME, MAXLINES, MAXCELLS, MAXCELLEN, false, true)==0, 0);
+    int lines_int=csv_obj.Load();
+    CHECK(lines_int>=-6 && lines_int<=MAXLINES, lines_int);
+    if (lines_int>=0) {
+        for (int line_int=0; line_int<lines_int; line_int++) {
+            const char *key_str=csv_obj.GetStrCell(line_int, 0);
+            if (key_str) {
+                int found_int=csv_obj.FindKey(key_str);
+                // a duplicate key is found on its first line
+                CHECK(found_int>=0 && found_int<=line_int, found_int);
+                csv_obj.GetInt(key_str);
+                csv_obj.GetFloat(key_str);
+                csv_obj.GetStr(key_str);
+            }
+        }
+        CHECK(csv_obj.FindKey("")==-1 && csv_obj.FindKey("TOOLONG")==-1, 0);
+        CHECK(csv_obj.SetInt("K", 123456)==-2, 0);
+        CHECK(csv_obj.SetInt("TOOLONG", 1)<0, 0); // -1, or -3 if the file is full
+        int result_int=csv_obj.SetInt("K", 12);
+        CHECK(result_int==0 || result_int==-3, result_int);
+        if (result_int==0)
+            CHECK(csv_obj.GetInt("K")==12, csv_obj.GetInt("K"));
+        result_int=csv_obj.Save();
+        CHECK(result_int>=0, result_int);
+    }
+    csv_obj.Release();
+}
+
+static void fuzz_rows(void) {
+    rgCsvPosix storage_obj;
+    storage_obj.SetRoot(Root_str);
+    rgCsvRows rows_obj;
+    rows_obj.SetStorage(&storage_obj);
+    CHECK(rows_obj.Open(FILE_NAME)==0, 0);
+    int result_int;
+    while ((result_int=rows_obj.Next())>0) {
+        CHECK(result_int<=rgCsvRows::MAXCELLS && result_int==rows_obj.Count(), result_int);
+        CHECK(rows_obj.GetStr(-1)==NULL && rows_obj.GetStr(result_int)==NULL, result_int);
+        for (int column_int=0; column_int<result_int; column_int++) {
+            const char *value_str=rows_obj.GetStr(column_int);
+            CHECK(value_str && strlen(value_str)<=rgCsvRows::LINE_SIZE, column_int);
+            rows_obj.GetInt(column_int);
+            rows_obj.GetFloat(column_int);
+        }
+        CHECK(rows_obj.Line()>0, rows_obj.Line());
+    }
+    CHECK(result_int>=-6 && result_int<=0, result_int);
+    rows_obj.Close();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static bool initialized=false;
+    if (!initialized) {
+        if (!mkdtemp(Root_str)) {
+            perror("csvfuzz: mkdtemp");
+            exit(1);
+        }
+        initialized=true;
+    }
+    write_input(data, size);
+    fuzz_reader();
+    fuzz_positional();
+    write_input(data, size); // restore the input, Save() has replaced it
+    fuzz_keyed();
+    write_input(data, size);
+    fuzz_rows();
+    Iteration++;
+    return 0;
+}
+
+#ifndef CSVFUZZ_LIBFUZZER
+static const char *Seeds[]={
+    "# Application parameters\nTXID,6454\nMONO,78\nPAL,0\n",
+    "TXID , 1 \r\nMONO,-12\r\n\r\n# comment\n  PAL,x\n",
+    "# mixer\nIN,0,-30,5\nCUR,1,0,10\nMIX,0,1,50\nOUT,0,-100,100\n",
+    ",,,\n1,2,3,4\na,bb,ccc,dddd\n-1,+2,0x1F,1e3\n",
+    "K,1\nK,2\nL,3\nM,4\nN,5\nO,6\n",
+};
+
+// random edits biased towards the characters which matter to the parser
+static void mutate(std::string *input, std::mt19937 *rng) {
+    static const char SPECIALS[]=",\n\r# -+0123456789x \t";
+    int edits=1+(*rng)()%8;
+    for (int edit=0; edit<edits; edit++) {
+        size_t position=input->empty() ? 0 : (*rng)()%(input->size()+1);
+        switch ((*rng)()%6) {
+            case 0:
+                input->insert(position, 1, SPECIALS[(*rng)()%(sizeof(SPECIALS)-1)]);
+                break;
+            case 1:
+                input->insert(position, 1, (char)(*rng)());
+                break;
+            case 2:
+                if (position<input->size())
+                    input->erase(position, 1+(*rng)()%4);
+                break;
+            case 3:
+                if (position<input->size())
+                    (*input)[position]^=1<<((*rng)()%8);
+                break;
+            case 4: { // long runs cross the line and block sizes
+                size_t count=1+(*rng)()%(rgCsvReader::BLOCK_SIZE+64);
+                input->insert(position, count, SPECIALS[(*rng)()%(sizeof(SPECIALS)-1)]);
+                break;
+            }
+            case 5:
+                if (!input->empty()) {
+                    size_t start=(*rng)()%input->size();
+                    input->insert(position, input->substr(start, (*rng)()%32));
+                }
+                break;
+        }
+    }
+}
+
+static void cleanup(void) {
+    std::string path=std::string(Root_str)+FILE_NAME;
+    unlink(path.c_str());
+    unlink((path+".tmp").c_str());
+    rmdir(Root_str);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long iterations=100000;
+    unsigned long seed=1;
+    std::vector<const char *> files;
+    for (int idx=1; idx<argc; idx++) {
+        if (strcmp(argv[idx], "-n")==0 && idx+1<argc)
+            iterations=strtoul(argv[++idx], NULL, 10);
+        else if (strcmp(argv[idx], "-s")==0 && idx+1<argc)
+            seed=strtoul(argv[++idx], NULL, 10);
+        else if (argv[idx][0]=='-') {
+            fprintf(stderr, "Usage: %s [-n iterations] [-s seed] [file.csv...]\n", argv[0]);
+            return 1;
+        }
+        else
+            files.push_back(argv[idx]);
+    }
+    if (!files.empty()) {
+        for (const char *file : files) {
+            std::ifstream input_file(file, std::ios::binary);
+            if (!input_file) {
+                fprintf(stderr, "Error: cannot open %s\n", file);
+                return 1;
+            }
+            std::string input((std::istreambuf_iterator<char>(input_file)), std::istreambuf_iterator<char>());
+            LLVMFuzzerTestOneInput((const uint8_t *)input.data(), input.size());
+        }
+    }
+    else {
+        std::mt19937 rng(seed);
+        const size_t seeds=sizeof(Seeds)/sizeof(Seeds[0]);
+        for (unsigned long idx=0; idx<iterations; idx++) {
+            std::string input=Seeds[idx%seeds];
+            mutate(&input, &rng);
+            LLVMFuzzerTestOneInput((const uint8_t *)input.data(), input.size());
+        }
+    }
+    printf("%lu inputs, no failure\n", Iteration);
+    cleanup();
+    return 0;
+}
+#endif
@@ -0,0 +1,278 @@
+/* This program is published under the GNU General Public License.
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/* Host-side quality and throughput tests of rgRng, the generator of the hop sequences
+
+   Build: g++ -std=c++17 -O2 -I../libraries/rgRng -o rngtest rngtest.cpp ../libraries/rgRng/rgRng.cpp
+
+   Usage: rngtest [-n count] [-m maxchan]
+       -n number of values drawn by each statistical test, default 10000000
+       -m highest radio channel, see COM_MAXCHAN in Common.h, default 83
+   Tests:
+       chi-square   uniformity of Next(256) and of Next(maxchan+1), as used by Transceiver::arrange_values()
+       serial       correlation of consecutive 32-bit values (Knuth's serial correlation coefficient)
+       gap          lengths of the gaps between values in the lower half of the range (Knuth's gap test)
+       hopping      the RF24Channels[] permutations generated for every session key 1-65535 :
+                    position of each channel, distance between consecutive channels,
+                    channels shared at the same position by 2 links with different keys
+       throughput   values per second of Next(), Next(maxchan+1) and permutations per second
+   a p-value below 0.001 or above 0.999 is reported as FAIL, the exit status is the number of failed tests :
+   0 means no regression, the program can be run after any change of rgRng or of arrange_values()
+
+   Known failure (rgRng v1.1.2) : "hopping: position" fails, because rgRng::Seed() fills the xorwow state
+   with seed+0..seed+4 and consecutive session keys produce correlated first values, so some channels
+   are more frequent than others at a given position of RF24Channels[]. The collision rate between
+   2 links is not affected. This test is reported as XFAIL and not counted ; if it passes, it is reported
+   as XPASS and counted, so that KNOWN_FAILURE is cleared when Seed() is fixed (Tx and Rx must then be
+   flashed with the same version, their hop sequences change)
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "rgRng.h"
+
+// must match Transceiver::DEF_MONOCHAN and Transceiver::arrange_values()
+const uint8_t DEF_MONOCHAN=0x40;
+const double P_MIN=0.001;
+const double P_MAX=0.999;
+const bool KNOWN_FAILURE=true; // "hopping: position", see above
+
+static int Failures=0;
+
+// upper tail probability of the chi-square distribution, Wilson-Hilferty approximation (good for dof>=30)
+static double chi2_pvalue(double chi2, double dof) {
+    double z=(cbrt(chi2/dof)-(1-2/(9*dof)))/sqrt(2/(9*dof));
+    return 0.5*erfc(z/sqrt(2));
+}
+
+// two-sided probability of a standard normal value
+static double normal_pvalue(double z) {
+    return erfc(fabs(z)/sqrt(2));
+}
+
+// known_failure: the test is expected to fail, only a pass is counted
+static void report(const char *name, const char *detail, double pvalue, bool known_failure=false) {
+    bool pass=(pvalue>=P_MIN && pvalue<=P_MAX);
+    if (pass==known_failure)
+        Failures++;
+    const char *result_str=known_failure ? (pass ? "XPASS" : "XFAIL") : (pass ? "PASS" : "FAIL");
+    printf("%-28s %-40s p=%.4f %s\n", name, detail, pvalue, result_str);
+}
+
+static double chi2_uniform(const std::vector<uint64_t> &counts, double expected) {
+    double chi2=0;
+    for (uint64_t count : counts)
+        chi2+=(count-expected)*(count-expected)/expected;
+    return chi2;
+}
+
+static void test_chi_square(uint32_t range, uint64_t count) {
+    rgRng rng;
+    rng.Seed(12345);
+    std::vector<uint64_t> counts(range, 0);
+    for (uint64_t idx=0; idx<count; idx++)
+        counts[rng.Next(range)]++;
+    double chi2=chi2_uniform(counts, (double)count/range);
+    char detail[64];
+    snprintf(detail, sizeof(detail), "Next(%u) chi2=%.1f dof=%u", range, chi2, range-1);
+    report("chi-square", detail, chi2_pvalue(chi2, range-1));
+}
+
+static void test_serial_correlation(uint64_t count) {
+    rgRng rng;
+    rng.Seed(54321);
+    double first=rng.Next(), previous=first;
+    double sum=first, sum_squares=first*first, sum_products=0;
+    for (uint64_t idx=1; idx<count; idx++) {
+        double value=rng.Next();
+        sum+=value;
+        sum_squares+=value*value;
+        sum_products+=previous*value;
+        previous=value;
+    }
+    sum_products+=previous*first; // circular, as in Knuth
+    double n=count;
+    double correlation=(n*sum_products-sum*sum)/(n*sum_squares-sum*sum);
+    // mean -1/(n-1), standard deviation about 1/sqrt(n)
+    double z=(correlation+1/(n-1))*sqrt(n);
+    char detail[64];
+    snprintf(detail, sizeof(detail), "coefficient=%+.6f", correlation);
+    report("serial correlation", detail, normal_pvalue(z));
+}
+
+static void test_gap(uint64_t count) {
+    const int MAXGAP=16; // gaps of MAXGAP values or more are counted together
+    const double PROBABILITY=0.5; // a value is in the lower half of the range
+    rgRng rng;
+    rng.Seed(777);
+    std::vector<uint64_t> gaps(MAXGAP+1, 0);
+    uint64_t total=0;
+    int length=0;
+    for (uint64_t idx=0; idx<count; idx++) {
+        if (rng.Next()<0x80000000u) {
+            gaps[length<MAXGAP ? length : MAXGAP]++;
+            total++;
+            length=0;
+        }
+        else
+            length++;
+    }
+    double chi2=0;
+    for (int gap=0; gap<=MAXGAP; gap++) {
+        double probability=gap<MAXGAP ? PROBABILITY*pow(1-PROBABILITY, gap) : pow(1-PROBABILITY, MAXGAP);
+        double expected=total*probability;
+        chi2+=(gaps[gap]-expected)*(gaps[gap]-expected)/expected;
+    }
+    char detail[64];
+    snprintf(detail, sizeof(detail), "%llu gaps chi2=%.1f dof=%d", (unsigned long long)total, chi2, MAXGAP);
+    // dof<30 : the approximation is less accurate in the tails, but good enough to detect a defect
+    report("gap", detail, chi2_pvalue(chi2, MAXGAP));
+}
+
+// copy of Transceiver::arrange_values()
+static void arrange_values(rgRng *rng, unsigned int key, uint8_t max_value, uint8_t ignored_value1, uint8_t ignored_value2,
+    uint8_t sizeof_values_out, uint8_t *values_out) {
+    const uint8_t NO_VALUE=255;
+    const uint8_t all_values=sizeof_values_out+2;
+    std::vector<bool> available_values(all_values, true);
+    available_values[ignored_value1]=false;
+    available_values[ignored_value2]=false;
+    for (int idx=0; idx<sizeof_values_out; idx++)
+        values_out[idx]=NO_VALUE;
+    rng->Seed(key);
+    for (int idx=0; idx<sizeof_values_out; idx++) {
+        while (values_out[idx]==NO_VALUE) {
+            uint8_t rnd_value=rng->Next(max_value+1);
+            if (available_values[rnd_value]) {
+                available_values[rnd_value]=false;
+                values_out[idx]=rnd_value;
+            }
+        }
+    }
+}
+
+static void test_hopping(uint8_t maxchan) {
+    const uint32_t KEYS=65535; // SessionKey is 16 bits, 0 is not used
+    const uint8_t mono_channel=DEF_MONOCHAN; // the most common case, MonoChannel is DEF_MONOCHAN until paired
+    const uint8_t size=maxchan-1;
+    rgRng rng;
+    std::vector<uint8_t> sequences((size_t)KEYS*size);
+    for (uint32_t key=1; key<=KEYS; key++)
+        arrange_values(&rng, key, maxchan, DEF_MONOCHAN, mono_channel, size, &sequences[(key-1)*size]);
+
+    // each channel should appear equally often at each position
+    std::vector<uint64_t> positions((size_t)size*(maxchan+1), 0);
+    for (uint32_t key=0; key<KEYS; key++)
+        for (uint8_t pos=0; pos<size; pos++)
+            positions[pos*(maxchan+1)+sequences[key*size+pos]]++;
+    double chi2=0;
+    // channels 0-maxchan except DEF_MONOCHAN (==mono_channel) : size+1 candidates, one of them left out by each key
+    const int candidates=size+1;
+    double expected=(double)KEYS/candidates;
+    for (uint8_t pos=0; pos<size; pos++)
+        for (int channel=0; channel<=maxchan; channel++) {
+            if (channel==DEF_MONOCHAN) // never used, see arrange_values()
+                continue;
+            double count=positions[pos*(maxchan+1)+channel];
+            chi2+=(count-expected)*(count-expected)/expected;
+        }
+    double dof=(double)size*(candidates-1);
+    char detail[64];
+    snprintf(detail, sizeof(detail), "channel per position chi2=%.0f dof=%.0f", chi2, dof);
+    report("hopping: position", detail, chi2_pvalue(chi2, dof), KNOWN_FAILURE);
+
+    // distance between consecutive channels, a short hop is more exposed to the same interference
+    std::vector<uint64_t> distances(maxchan+1, 0);
+    uint64_t hops=0;
+    for (uint32_t key=0; key<KEYS; key++)
+        for (uint8_t pos=0; pos<size; pos++) {
+            uint8_t current=sequences[key*size+pos];
+            uint8_t next=sequences[key*size+(pos+1)%size];
+            distances[abs(next-current)]++;
+            hops++;
+        }
+    uint64_t short_hops=distances[1]+distances[2];
+    double mean_distance=0;
+    for (int distance=0; distance<=maxchan; distance++)
+        mean_distance+=(double)distance*distances[distance]/hops;
+    printf("%-28s mean distance %.2f channels, %.2f%% of the hops within 2 channels (random: %.2f%%)\n", "hopping: distance",
+        mean_distance, 100.0*short_hops/hops, 100.0*4/candidates);
+
+    // 2 co-located links with different keys : number of positions where they use the same channel
+    // expected about size/(size-1) per cycle if the sequences are independent
+    rng.Seed(999);
+    const int PAIRS=100000;
+    double shared=0, max_shared=0;
+    for (int pair=0; pair<PAIRS; pair++) {
+        uint32_t key1=rng.Next(KEYS), key2=rng.Next(KEYS);
+        if (key1==key2)
+            continue;
+        int count=0;
+        for (uint8_t pos=0; pos<size; pos++)
+            count+=sequences[key1*size+pos]==sequences[key2*size+pos];
+        shared+=count;
+        max_shared=count>max_shared ? count : max_shared;
+    }
+    printf("%-28s %.3f channels shared per cycle of %u hops on average, %.0f at most (independent: %.3f)\n",
+        "hopping: collisions", shared/PAIRS, size, max_shared, (double)size/(size-1));
+}
+
+template <typename F>
+static void measure(const char *name, uint64_t count, const char *unit, F function) {
+    auto start=std::chrono::steady_clock::now();
+    uint32_t sink=0;
+    for (uint64_t idx=0; idx<count; idx++)
+        sink+=function();
+    double seconds=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    printf("%-28s %.1f M%s/s (checksum %08x)\n", name, count/seconds/1e6, unit, sink);
+}
+
+static void test_throughput(uint8_t maxchan, uint64_t count) {
+    rgRng rng;
+    measure("throughput: Next()", count, "values", [&]() { return rng.Next(); });
+    measure("throughput: Next(maxchan+1)", count, "values", [&]() { return rng.Next(maxchan+1); });
+    std::vector<uint8_t> sequence(maxchan-1);
+    uint32_t key=0;
+    measure("throughput: permutations", count/1000, "permutations", [&]() {
+        key=(key%65535)+1;
+        arrange_values(&rng, key, maxchan, DEF_MONOCHAN, DEF_MONOCHAN+1, maxchan-1, sequence.data());
+        return sequence[0];
+    });
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t count=10000000;
+    int maxchan=83;
+    for (int idx=1; idx<argc; idx++) {
+        if (strcmp(argv[idx], "-n")==0 && idx+1<argc)
+            count=strtoull(argv[++idx], NULL, 10);
+        else if (strcmp(argv[idx], "-m")==0 && idx+1<argc)
+            maxchan=atoi(argv[++idx]);
+        else {
+            fprintf(stderr, "Usage: %s [-n count] [-m maxchan]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (count<1000 || maxchan<=DEF_MONOCHAN || maxchan>125) {
+        fprintf(stderr, "count must be at least 1000, maxchan must be in the range %d-125\n", DEF_MONOCHAN+1);
+        return 1;
+    }
+    test_chi_square(256, count);
+    test_chi_square(maxchan+1, count);
+    test_serial_correlation(count);
+    test_gap(count);
+    test_hopping(maxchan);
+    test_throughput(maxchan, count);
+    return Failures;
+}
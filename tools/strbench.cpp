@@ -0,0 +1,222 @@
+/* This program is published under the GNU General Public License.
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/* Host-side microbenchmark of the rgStr parsing toolkit against the functions it replaces
+
+   Build: g++ -std=c++17 -O2 -I../libraries/rgStr -o strbench strbench.cpp ../libraries/rgStr/rgStr.cpp
+
+   Usage: strbench [-n iterations]
+       -n number of passes over the sample cells, default 1000000
+   Compared:
+       trim     TrimWhitespace() of rgStr v1.1 (strlen, then copy of the characters)  / TrimSpan()
+       int      isdigit() loop + strtoll() of rgCsv v2.0 parse_int(), and atoi()       / ParseInt()
+       hex      Hex2Dec() of rgStr v1.1 (multiplication by 1<<n)                       / ParseHex()
+       format   sprintf("%d")                                                          / FormatInt()
+   the old functions are copied below, the results of the old and new functions are compared before timing
+   the timings of the host are much shorter than on the board, compare the ratios rather than the absolute values
+*/
+
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "rgStr.h"
+
+// cells found in the param and mixer files of Tx and Rx
+static const char *IntCells[]={"64540", " 78 ", "0", "-100", "  1500", "-2147483648", "2147483647", "12 ", "-30", "5"};
+static const char *HexCells[]={"FC1C", "4e", "0", "7FFFFFFF", "deadbeef", "1a2B", "00FF", "8000"};
+static const int32_t FormatValues[]={64540, 78, 0, -100, 1500, INT32_MIN, INT32_MAX, 12, -30, 5};
+const int INT_CELLS=sizeof(IntCells)/sizeof(IntCells[0]);
+const int HEX_CELLS=sizeof(HexCells)/sizeof(HexCells[0]);
+const int FORMAT_VALUES=sizeof(FormatValues)/sizeof(FormatValues[0]);
+const int CELL_SIZE=16;
+
+/* Old functions *************************************************************/
+
+// rgStr v1.1
+__attribute__((noinline)) static char *old_TrimWhitespace(char *line_out) {
+    char *ptr=line_out;
+    while (isspace(*ptr))
+        ptr++;
+    if (*ptr) {
+        char *last_chr=ptr+strlen(ptr)-1;
+        while (last_chr>ptr && isspace(*last_chr))
+            last_chr--;
+        *(last_chr+1)=0;
+    }
+    if (ptr!=line_out)
+        memmove(line_out, ptr, strlen(ptr)+1);
+    return line_out;
+}
+
+static short old_ishexdigit(char a_chr) {
+    return (a_chr>='0' && a_chr<='9') || (a_chr>='A' && a_chr<='F') || (a_chr>='a' && a_chr<='f');
+}
+
+// rgStr v1.1
+__attribute__((noinline)) static unsigned long old_Hex2Dec(const char *hex_str, short length_byt) {
+    unsigned long retval_lng=0;
+    for (short idx_byt=0; idx_byt<length_byt; idx_byt++) {
+        char x_chr=toupper(hex_str[idx_byt]);
+        if (old_ishexdigit(x_chr))
+            retval_lng+=(x_chr-(x_chr<='9' ? '0' : '7'))*(1UL<<(4*(length_byt-1-idx_byt)));
+        else
+            break;
+    }
+    return retval_lng;
+}
+
+// rgCsv v2.0 parse_int(), the cell is already trimmed
+__attribute__((noinline)) static bool old_parse_int(const char *cell_str, int32_t *value_out) {
+    const char *ptr=cell_str;
+    if (*ptr=='-')
+        ptr++;
+    if (*ptr=='\0')
+        return false;
+    for (const char *digit_ptr=ptr; *digit_ptr; digit_ptr++) {
+        if (!isdigit((unsigned char)*digit_ptr))
+            return false;
+    }
+    if (strlen(ptr)>10)
+        return false;
+    long long value_lng=strtoll(cell_str, NULL, 10);
+    if (value_lng<INT32_MIN || value_lng>INT32_MAX)
+        return false;
+    *value_out=(int32_t)value_lng;
+    return true;
+}
+
+/* Benchmark *****************************************************************/
+
+static int Failures=0;
+
+static void check(bool condition, const char *name, const char *cell_str) {
+    if (!condition) {
+        fprintf(stderr, "Error: %s differs for \"%s\"\n", name, cell_str);
+        Failures++;
+    }
+}
+
+// compare the results of the old and new functions on the sample cells
+static void check_results(void) {
+    char cell_str[CELL_SIZE];
+    for (int idx=0; idx<INT_CELLS; idx++) {
+        strcpy(cell_str, IntCells[idx]);
+        old_TrimWhitespace(cell_str);
+        StrSpan span=TrimSpan(MakeSpan(IntCells[idx]));
+        check(span.len==strlen(cell_str) && memcmp(span.ptr, cell_str, span.len)==0, "trim", IntCells[idx]);
+        int32_t old_value=0, new_value=0;
+        size_t used=0;
+        bool old_ok=old_parse_int(cell_str, &old_value);
+        bool new_ok=ParseInt(span, INT32_MIN, INT32_MAX, &new_value, &used)==STR_PARSE_OK && used==span.len;
+        check(old_ok==new_ok && old_value==new_value, "int", IntCells[idx]);
+        check(atoi(cell_str)==new_value, "atoi", IntCells[idx]);
+    }
+    for (int idx=0; idx<HEX_CELLS; idx++) {
+        uint32_t new_value=0;
+        ParseHex(MakeSpan(HexCells[idx]), UINT32_MAX, &new_value);
+        check(old_Hex2Dec(HexCells[idx], strlen(HexCells[idx]))==new_value, "hex", HexCells[idx]);
+    }
+    for (int idx=0; idx<FORMAT_VALUES; idx++) {
+        char old_str[FORMATINT_SIZE], new_str[FORMATINT_SIZE];
+        sprintf(old_str, "%d", (int)FormatValues[idx]);
+        FormatInt(FormatValues[idx], new_str);
+        check(strcmp(old_str, new_str)==0, "format", old_str);
+    }
+}
+
+template <typename F>
+static double measure(long iterations, int cells, F function) {
+    auto start=std::chrono::steady_clock::now();
+    uint32_t sink=0;
+    for (long pass=0; pass<iterations; pass++)
+        for (int idx=0; idx<cells; idx++)
+            sink+=function(idx);
+    double seconds=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    if (sink==0x5A5A5A5A)
+        printf(" "); // uses the results, so that the calls are not removed
+    return seconds*1e9/(iterations*cells);
+}
+
+static void print_result(const char *name, const char *old_name, double old_ns, const char *new_name, double new_ns) {
+    printf("%-8s %-22s %7.2f ns   %-22s %7.2f ns   x%.1f\n", name, old_name, old_ns, new_name, new_ns, old_ns/new_ns);
+}
+
+int main(int argc, char *argv[]) {
+    long iterations=1000000;
+    for (int idx=1; idx<argc; idx++) {
+        if (strcmp(argv[idx], "-n")==0 && idx+1<argc)
+            iterations=atol(argv[++idx]);
+        else {
+            fprintf(stderr, "Usage: %s [-n iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (iterations<1) {
+        fprintf(stderr, "Error: iterations must be positive\n");
+        return 1;
+    }
+    check_results();
+    if (Failures)
+        return 1;
+    printf("%s %s, %ld iterations, time per cell\n", STRLIB_NAME, STRLIB_VERSION, iterations);
+
+    // the cells are copied by both, TrimWhitespace() modifies its argument
+    char cell_str[CELL_SIZE];
+    double old_ns=measure(iterations, INT_CELLS, [&](int idx) {
+        strcpy(cell_str, IntCells[idx]);
+        return (uint32_t)old_TrimWhitespace(cell_str)[0];
+    });
+    double new_ns=measure(iterations, INT_CELLS, [&](int idx) {
+        strcpy(cell_str, IntCells[idx]);
+        return (uint32_t)TrimSpan(MakeSpan(cell_str)).len;
+    });
+    print_result("trim", "TrimWhitespace()", old_ns, "TrimSpan()", new_ns);
+
+    // the cells are trimmed by both : the old parser needs a trimmed string, ParseInt() a trimmed span
+    old_ns=measure(iterations, INT_CELLS, [&](int idx) {
+        strcpy(cell_str, IntCells[idx]);
+        int32_t value=0;
+        old_parse_int(old_TrimWhitespace(cell_str), &value);
+        return (uint32_t)value;
+    });
+    new_ns=measure(iterations, INT_CELLS, [&](int idx) {
+        int32_t value=0;
+        ParseInt(TrimSpan(MakeSpan(IntCells[idx])), INT32_MIN, INT32_MAX, &value);
+        return (uint32_t)value;
+    });
+    print_result("int", "isdigit()+strtoll()", old_ns, "ParseInt()", new_ns);
+    old_ns=measure(iterations, INT_CELLS, [&](int idx) {
+        return (uint32_t)atoi(IntCells[idx]); // no check, no trailing white-space
+    });
+    print_result("int", "atoi()", old_ns, "ParseInt()", new_ns);
+
+    old_ns=measure(iterations, HEX_CELLS, [&](int idx) {
+        return (uint32_t)old_Hex2Dec(HexCells[idx], strlen(HexCells[idx]));
+    });
+    new_ns=measure(iterations, HEX_CELLS, [&](int idx) {
+        uint32_t value=0;
+        ParseHex(MakeSpan(HexCells[idx]), UINT32_MAX, &value);
+        return value;
+    });
+    print_result("hex", "Hex2Dec()", old_ns, "ParseHex()", new_ns);
+
+    char buffer_str[FORMATINT_SIZE];
+    old_ns=measure(iterations, FORMAT_VALUES, [&](int idx) {
+        return (uint32_t)sprintf(buffer_str, "%d", (int)FormatValues[idx]);
+    });
+    new_ns=measure(iterations, FORMAT_VALUES, [&](int idx) {
+        return (uint32_t)FormatInt(FormatValues[idx], buffer_str);
+    });
+    print_result("format", "sprintf(\"%d\")", old_ns, "FormatInt()", new_ns);
+    return 0;
+}
@@ -0,0 +1,171 @@
+/* This program is published under the GNU General Public License.
+ * This program is free software and you can redistribute it and/or modify it under the terms
+ * of the GNU General  Public License as published by the Free Software Foundation, version 3.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY.
+ * See the GNU General Public License for more details : https://www.gnu.org/licenses/ *GPL
+ *
+ * Installation, usage : https://github.com/rigou/nRF24L01-FHSS/
+*/
+
+/* Host-side decoder of the radio event trace dumped by Transceiver::DumpTrace()
+
+   Capture the dump: send 'T' to Tx or Rx and save the serial output to a file, eg with
+       stty -F /dev/ttyUSB0 115200 raw && cat /dev/ttyUSB0 > dump.bin & echo -n T > /dev/ttyUSB0
+   the debug output captured around the dump is skipped, the last dump of the file is decoded
+
+   Build: g++ -std=c++17 -O2 -o trace2csv trace2csv.cpp
+
+   Usage: trace2csv [-t] dump.bin
+       writes a CSV file to stdout : one line per record
+       -t writes a timeline instead : one character per datagram, 64 datagrams per line
+          Tx : '.'=acknowledged 'x'=not acknowledged '0'-'9'=acknowledged after n retransmissions
+          Rx : '.'=received 'd'=received by the diversity radio 'x'=missing
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// must match Transceiver::TraceRecord and Transceiver::DumpTrace()
+const uint8_t TRACE_VERSION=2; // version 1 : Rx did not record the missing datagrams
+const uint8_t TRF_TX=0x1;
+const uint8_t TRF_ACK=0x2;
+const uint8_t TRF_DIVERSITY=0x4;
+const uint8_t TRF_MISSED=0x8;
+const char MAGIC[]="NRFTRACE";
+const size_t MAGIC_SIZE=8;
+const size_t HEADER_SIZE=16;
+const size_t RECORD_SIZE=12;
+
+struct TraceRecord {
+    uint32_t time;
+    uint16_t number;
+    uint8_t channel;
+    uint8_t type;
+    uint8_t flags;
+    uint8_t arc;
+    uint8_t state;
+};
+
+static uint16_t get_u16(const uint8_t *bytes) {
+    return bytes[0] | (bytes[1]<<8);
+}
+
+static uint32_t get_u32(const uint8_t *bytes) {
+    return get_u16(bytes) | ((uint32_t)get_u16(bytes+2)<<16);
+}
+
+// Find the last dump in the captured data and decode its records
+// Return value: 0=OK, -1=no dump found, -2=unsupported version, -3=truncated dump
+static int decode(const std::vector<uint8_t> &data, std::vector<TraceRecord> *records_out, uint32_t *total_out) {
+    size_t start=data.size();
+    for (size_t pos=0; pos+HEADER_SIZE<=data.size(); pos++) {
+        if (memcmp(&data[pos], MAGIC, MAGIC_SIZE)==0)
+            start=pos;
+    }
+    if (start==data.size())
+        return -1;
+    const uint8_t *header=&data[start];
+    if (header[8]<1 || header[8]>TRACE_VERSION || header[9]!=RECORD_SIZE)
+        return -2;
+    uint16_t count=get_u16(header+10);
+    *total_out=get_u32(header+12);
+    if (start+HEADER_SIZE+count*RECORD_SIZE>data.size())
+        return -3;
+    for (uint16_t idx=0; idx<count; idx++) {
+        const uint8_t *bytes=&data[start+HEADER_SIZE+idx*RECORD_SIZE];
+        TraceRecord record;
+        record.time=get_u32(bytes);
+        record.number=get_u16(bytes+4);
+        record.channel=bytes[6];
+        record.type=bytes[7];
+        record.flags=bytes[8];
+        record.arc=bytes[9];
+        record.state=bytes[10];
+        records_out->push_back(record);
+    }
+    return 0;
+}
+
+static void print_csv(const std::vector<TraceRecord> &records) {
+    printf("time_us,delta_us,number,channel,type,dir,ack,diversity,missed,arc,state\n");
+    for (size_t idx=0; idx<records.size(); idx++) {
+        const TraceRecord &record=records[idx];
+        uint32_t delta=idx ? record.time-records[idx-1].time : 0; // unsigned arithmetic handles the micros() wrap-around
+        printf("%u,%u,%u,%u,0x%x,%s,%d,%d,%d,%u,%u\n", record.time, delta, record.number, record.channel, record.type,
+            (record.flags & TRF_TX) ? "tx" : "rx", (record.flags & TRF_ACK) ? 1 : 0, (record.flags & TRF_DIVERSITY) ? 1 : 0,
+            (record.flags & TRF_MISSED) ? 1 : 0, record.arc, record.state);
+    }
+}
+
+static void print_timeline(const std::vector<TraceRecord> &records) {
+    const unsigned int LINE_LENGTH=64;
+    std::vector<char> symbols;
+    std::vector<uint32_t> times; // time of each symbol
+    for (size_t idx=0; idx<records.size(); idx++) {
+        const TraceRecord &record=records[idx];
+        if (record.flags & TRF_TX) {
+            if (!(record.flags & TRF_ACK))
+                symbols.push_back('x');
+            else if (record.arc)
+                symbols.push_back(record.arc<10 ? '0'+record.arc : '+');
+            else
+                symbols.push_back('.');
+            times.push_back(record.time);
+        }
+        else {
+            // Rx records the datagrams received and the missing ones, a gap in the numbers is a missing datagram
+            // not recorded : in a dump of version 1, or while the recording was suspended by a previous dump
+            if (idx) {
+                uint16_t missing=record.number-records[idx-1].number-1;
+                for (uint16_t count=0; count<missing && count<1000; count++) {
+                    symbols.push_back('x');
+                    times.push_back(records[idx-1].time);
+                }
+            }
+            if (record.flags & TRF_MISSED)
+                symbols.push_back('x');
+            else
+                symbols.push_back((record.flags & TRF_DIVERSITY) ? 'd' : '.');
+            times.push_back(record.time);
+        }
+    }
+    for (size_t idx=0; idx<symbols.size(); idx++) {
+        if (idx%LINE_LENGTH==0)
+            printf("%s%10.3f ms  ", idx ? "\n" : "", (times[idx]-times[0])/1000.0);
+        putchar(symbols[idx]);
+    }
+    putchar('\n');
+}
+
+int main(int argc, char *argv[]) {
+    bool timeline=(argc==3 && strcmp(argv[1], "-t")==0);
+    if (argc!=2 && !timeline) {
+        fprintf(stderr, "Usage: %s [-t] dump.bin\n", argv[0]);
+        return 1;
+    }
+    std::ifstream file(argv[argc-1], std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "cannot open %s\n", argv[argc-1]);
+        return 1;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<TraceRecord> records;
+    uint32_t total=0;
+    int result=decode(data, &records, &total);
+    if (result<0) {
+        const char *errors[]={"", "no trace dump found", "unsupported dump version", "truncated dump"};
+        fprintf(stderr, "%s\n", errors[-result]);
+        return 1;
+    }
+    fprintf(stderr, "%zu records, %u recorded since startup\n", records.size(), total);
+    if (timeline)
+        print_timeline(records);
+    else
+        print_csv(records);
+    return 0;
+}